@@ -0,0 +1,99 @@
+#!/bin/bash
+#
+# Strong or weak scaling sweep of apso_bench over rank and thread counts,
+# writing <out>.csv and <out>.json with the speedup and efficiency of every
+# run relative to the run with the fewest ranks*threads of the same swarm.
+#
+#   ./scaling_sweep.sh [-m strong|weak] [-r "1 2 4 8"] [-t "1"] [-o scaling] [-- bench args]
+#
+# In strong scaling --particles is the total over all ranks, in weak scaling
+# it is the count per rank. The time of a run is its time to target when the
+# target was reached, and its wall time otherwise. Ranks are oversubscribed
+# by default so the sweep also runs on a single box, and the launcher can be
+# changed through MPIRUN, e.g. MPIRUN="mpiexec" or
+# MPIRUN="mpirun --allow-run-as-root --oversubscribe".
+
+mode="strong"
+ranks="1 2 4"
+threads="1"
+out="scaling"
+MPIRUN=${MPIRUN:-"mpirun --oversubscribe"}
+
+while getopts "m:r:t:o:h" opt; do
+    case ${opt} in
+        m) mode=${OPTARG} ;;
+        r) ranks=${OPTARG} ;;
+        t) threads=${OPTARG} ;;
+        o) out=${OPTARG} ;;
+        *) sed -n '3,14p' "$0"; exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ "${mode}" != "strong" ] && [ "${mode}" != "weak" ]; then
+    echo "unknown mode ${mode}"; exit 1
+fi
+weak_flag=""
+if [ "${mode}" = "weak" ]; then weak_flag="--weak"; fi
+
+if [ ! -x ./apso_bench ]; then
+    echo "apso_bench not found, build it with make bench"; exit 1
+fi
+
+# run the sweep, keeping a single csv header
+raw=$(mktemp)
+for t in ${threads}; do
+    for n in ${ranks}; do
+        echo "Starting ${mode} N=${n} threads=${t}" >&2
+        ${MPIRUN} -np ${n} ./apso_bench --format csv --threads ${t} ${weak_flag} "$@" > ${raw}.run
+        if [ $? -ne 0 ]; then
+            echo "Run failed for N=${n} threads=${t}" >&2; cat ${raw}.run >&2; rm -f ${raw} ${raw}.run; exit 1
+        fi
+        if [ ! -s ${raw} ]; then head -n 1 ${raw}.run > ${raw}; fi
+        tail -n +2 ${raw}.run >> ${raw}
+    done
+done
+
+# add the speedup and efficiency against the smallest run of each swarm
+awk -F, -v OFS=, -v mode=${mode} '
+    NR == 1 { print $0, "mode,speedup,efficiency"; next }
+    {
+        row[NR] = $0; swarm[NR] = $1
+        units[NR] = $4 * $5
+        time[NR] = ($9 != "") ? $9 : $10
+        if( !($1 in base_units) || units[NR] < base_units[$1] ){
+            base_units[$1] = units[NR]; base_time[$1] = time[NR]
+        }
+    }
+    END {
+        for(i = 2; i <= NR; ++i){
+            s = swarm[i]
+            if( mode == "strong" ){
+                speedup = base_time[s] / time[i]
+                eff = speedup * base_units[s] / units[i]
+            }else{
+                eff = base_time[s] / time[i]
+                speedup = eff * units[i] / base_units[s]
+            }
+            printf "%s,%s,%.6f,%.6f\n", row[i], mode, speedup, eff
+        }
+    }' ${raw} > ${out}.csv
+
+# turn the csv into a json array, quoting the text columns
+awk -F, '
+    NR == 1 { for(i = 1; i <= NF; ++i){ key[i] = $i }; nkeys = NF; print "["; next }
+    {
+        if( NR > 2 ){ print "," }
+        line = "  {"
+        for(i = 1; i <= nkeys; ++i){
+            v = $i
+            if( v == "" ){ v = "null" }
+            else if( v !~ /^-?[0-9.]+([eE][-+]?[0-9]+)?$/ ){ v = "\"" v "\"" }
+            line = line "\"" key[i] "\": " v (i < nkeys ? ", " : "")
+        }
+        printf "%s}", line
+    }
+    END { print ""; print "]" }' ${out}.csv > ${out}.json
+
+rm -f ${raw} ${raw}.run
+echo "Wrote ${out}.csv and ${out}.json" >&2
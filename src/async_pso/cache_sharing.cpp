@@ -0,0 +1,132 @@
+//
+//  cache_sharing.cpp
+//  async_pso
+//
+
+#include <cstdint>
+#include <cstring>
+#include "cache_sharing.hpp"
+
+namespace async {
+    namespace pso {
+
+        // ctor/dtor
+        cache_share_manager::cache_share_manager():max_entries(64), cache(nullptr),
+        dim(0), nsent(0), nreceived(0), peers(2)
+        {
+            set_mpi_comm(MPI_COMM_WORLD);
+        }
+
+        // set the communicator
+        void cache_share_manager::set_mpi_comm(MPI_Comm com) {
+            distributed::msg_manager2::set_mpi_comm(com);
+            int size = 1;
+            MPI_Comm_size(com, &size);
+            peers.setup(local_rank, size);
+        }
+
+        // seed the generator used to pick peers
+        void cache_share_manager::set_seed(unsigned seed) {
+            eng.seed(seed);
+        }
+
+        // settings
+        void cache_share_manager::set_num_peers(int k) {
+            peers.set_fanout(k);
+        }
+        void cache_share_manager::set_max_entries(size_t max_entries_) {
+            max_entries = max_entries_;
+        }
+
+        // attach the cache values are taken from and stored into
+        void cache_share_manager::attach(::pso::eval_cache& cache_, size_t dim_) {
+            cache = &cache_;
+            dim   = dim_;
+        }
+
+        // make progress on messages
+        void cache_share_manager::progress(bool share) {
+            check_message_completeness();
+            if( share ){ share_values(); }
+        }
+
+        // wait for all the values in flight to arrive
+        void cache_share_manager::finalize() {
+
+            // a rank is done once its sends were received, which are
+            // synchronous for that reason. The barrier completes once
+            // every rank got there
+            MPI_Request barrier = MPI_REQUEST_NULL;
+            bool in_barrier = false;
+            int done = 0;
+            while( !done ){
+                progress(false);
+                if( in_barrier ){
+                    MPI_Test(&barrier, &done, MPI_STATUS_IGNORE);
+                }else if( num_pending_sends() == 0 ){
+                    MPI_Ibarrier(comm, &barrier);
+                    in_barrier = true;
+                }
+            }
+
+            // finish any receive that was matched before the barrier finished
+            while( num_pending_receives() ){ check_message_completeness(); }
+        }
+
+        // get the number of values sent and received so far
+        size_t cache_share_manager::num_sent() const {
+            return nsent;
+        }
+        size_t cache_share_manager::num_received() const {
+            return nreceived;
+        }
+
+        // send the latest values to a few random peers
+        void cache_share_manager::share_values() {
+            if( cache == nullptr ){ return; }
+            const uint64_t count = cache->take_recent(outgoing, dim, max_entries);
+            if( count == 0 ){ return; }
+
+            peers.get_destinations(eng, samples);
+            for(int rank: samples){
+                uniq_msg_t msg_ = create_indep_message();
+                msg_->set_destination_rank(rank)
+                .set_msg_type(ShareValues)
+                .set_synchronous(true);
+
+                metadata_t mdata;
+                mdata.is_response = false;
+                mdata.mngr_id   = manager_id;
+                mdata.msg_id    = 0;
+                mdata.msg_type  = ShareValues;
+
+                // the values go out as [count, rows of (x, fval)]
+                const size_t nbytes = outgoing.size()*sizeof(double);
+                byte_t* buf = msg_->reserve_send_buffer(metadata_byte_content() + sizeof(uint64_t) + nbytes);
+                size_t offset = serialize_metadata(mdata, buf);
+                offset = util::serialize(count, buf, offset);
+                std::memcpy(buf + offset, outgoing.data(), nbytes);
+                nsent += count;
+
+                send_indep_message(msg_);
+            }
+        }
+
+        // overloaded response handler
+        void cache_share_manager::response_handler(byte_t* buf, size_t size, metadata_t, int) {
+            uint64_t count = 0;
+            size_t offset = util::deserialize(count, buf);
+            const size_t row = (dim + 1)*sizeof(double);
+            if( cache == nullptr || size < offset + count*row ){ return; }
+
+            // the buffer has no alignment guarantees, so copy each row out
+            std::vector<double> x(dim + 1);
+            for(uint64_t k = 0; k < count; ++k, offset += row){
+                std::memcpy(x.data(), buf + offset, row);
+                cache->insert_shared(x.data(), dim, x[dim]);
+            }
+            nreceived += count;
+        }
+
+    }
+} // end namespace async
@@ -0,0 +1,93 @@
+//
+//  cache_sharing.hpp
+//  async_pso
+//
+
+#ifndef cache_sharing_hpp
+#define cache_sharing_hpp
+
+#include <random>
+#include <vector>
+#include "../distr_utility/message_manager2.hpp"
+#include "../particle/eval_cache.hpp"
+#include "topology.hpp"
+
+namespace async {
+    namespace pso {
+
+        /*
+         Class sharing objective values between the evaluation caches
+         of different ranks. Every share period a rank sends the values
+         it computed since the last share to a few random peers, which
+         store them in their own caches. Messages only go one way, so
+         no rank ever waits on another.
+         */
+        class cache_share_manager : public distributed::msg_manager2 {
+        public:
+
+            // ctor/dtor
+            cache_share_manager();
+            ~cache_share_manager() = default;
+
+            // set the communicator
+            void set_mpi_comm(MPI_Comm comm);
+
+            // seed the generator used to pick peers
+            void set_seed(unsigned seed);
+
+            // set the number of peers per share and the
+            // max number of values sent per share
+            void set_num_peers(int k = 2);
+            void set_max_entries(size_t max_entries = 64);
+
+            // attach the cache values are taken from and stored
+            // into, along with the dimension of the positions
+            void attach(::pso::eval_cache& cache, size_t dim);
+
+            // make progress on messages, sending out the
+            // latest values if share is true
+            void progress(bool share);
+
+            // wait for all the values in flight to arrive.
+            // Collective over the communicator
+            void finalize();
+
+            // get the number of values sent and received so far
+            size_t num_sent() const;
+            size_t num_received() const;
+
+        private:
+
+            // message types
+            enum msg_type: int {
+                ShareValues = 0
+            };
+
+            // settings
+            size_t                  max_entries;
+
+            // cache and counters
+            ::pso::eval_cache*      cache;
+            size_t                  dim, nsent, nreceived;
+            std::vector<double>     outgoing;
+
+            // peer selection
+            random_topology         peers;
+            std::vector<int>        samples;
+            std::mt19937            eng;
+
+            // type aliases
+            using byte_t = distributed::byte_t;
+            using metadata_t = distributed::msg_manager2::metadata_t;
+
+            // overloaded response handler
+            void response_handler(byte_t* buf, size_t size, metadata_t metadata, int src_rank);
+
+            // send the latest values to a few random peers
+            void share_values();
+
+        };
+    }
+} // end namespace async
+
+#endif /* cache_sharing_hpp */
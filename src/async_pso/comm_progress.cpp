@@ -0,0 +1,82 @@
+//
+//  comm_progress.cpp
+//  async_pso
+//
+
+#include <chrono>
+#include "comm_progress.hpp"
+
+namespace async {
+    namespace pso {
+
+        // ctor/dtor
+        comm_progress::comm_progress(global_comm& gcom_):gcom(gcom_), mode(OnIteration),
+        num2process(16), interval(1e-4), running(false)
+        {
+
+        }
+        comm_progress::~comm_progress() {
+            stop();
+        }
+
+        // set/get the progress mode
+        void comm_progress::set_mode(mode_t mode_) {
+            mode = mode_;
+        }
+        typename comm_progress::mode_t comm_progress::get_mode() const {
+            return mode;
+        }
+
+        // set the time between polls of the progress thread
+        // and the number of probes done per poll
+        void comm_progress::set_poll_interval(double seconds) {
+            interval = seconds;
+        }
+        void comm_progress::set_messages_per_poll(int num2process_) {
+            num2process = num2process_;
+        }
+
+        // start/stop the progress thread
+        void comm_progress::start() {
+            if( mode != Thread || running ){ return; }
+
+            // a second thread may only make MPI calls if MPI
+            // allows serialized calls from different threads
+            int provided = MPI_THREAD_SINGLE;
+            MPI_Query_thread(&provided);
+            if( provided < MPI_THREAD_SERIALIZED ){
+                mode = Polled;
+                return;
+            }
+
+            running = true;
+            worker  = std::thread(&comm_progress::progress_loop, this);
+        }
+        void comm_progress::stop() {
+            if( !running ){ return; }
+            running = false;
+            worker.join();
+        }
+
+        // make progress on messages from the calling thread
+        void comm_progress::poll() {
+            std::lock_guard<std::mutex> lk(lock);
+            gcom.check_messages(num2process);
+        }
+
+        // lock that must be held while touching the communicator
+        std::mutex& comm_progress::get_lock() {
+            return lock;
+        }
+
+        // progress thread loop
+        void comm_progress::progress_loop() {
+            const auto wait = std::chrono::duration<double>(interval);
+            while( running ){
+                poll();
+                std::this_thread::sleep_for(wait);
+            }
+        }
+
+    }
+} // end namespace async
@@ -0,0 +1,80 @@
+//
+//  comm_progress.hpp
+//  async_pso
+//
+
+#ifndef comm_progress_hpp
+#define comm_progress_hpp
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "global_communicator.hpp"
+
+namespace async {
+    namespace pso {
+
+        /*
+         Class that decides when incoming messages for a
+         global communicator get serviced. By default this only
+         happens once every message check period of the swarm,
+         but it can also be done between chunks of objective
+         evaluations or continuously by a dedicated thread, so
+         other ranks get their responses with bounded latency
+         even when the objective is expensive.
+         */
+        class comm_progress {
+        public:
+
+            // ways of making progress on messages
+            enum mode_t: int {
+                OnIteration = 0,    // only in the swarm message check
+                Polled,             // also between evaluation chunks
+                Thread              // continuously on a progress thread
+            };
+
+            // ctor/dtor
+            comm_progress(global_comm& gcom);
+            ~comm_progress();
+
+            // set/get the progress mode
+            void set_mode(mode_t mode);
+            mode_t get_mode() const;
+
+            // set the time between polls of the progress thread
+            // and the number of probes done per poll
+            void set_poll_interval(double seconds);
+            void set_messages_per_poll(int num2process);
+
+            // start/stop the progress thread, if the mode needs one.
+            // Thread mode falls back to Polled when MPI was not
+            // initialized with at least MPI_THREAD_SERIALIZED.
+            void start();
+            void stop();
+
+            // make progress on messages from the calling thread
+            void poll();
+
+            // lock that must be held while touching the communicator
+            std::mutex& get_lock();
+
+        private:
+
+            // internal state
+            global_comm&        gcom;
+            mode_t              mode;
+            int                 num2process;
+            double              interval;
+            std::mutex          lock;
+            std::thread         worker;
+            std::atomic<bool>   running;
+
+            // progress thread loop
+            void progress_loop();
+
+        };
+
+    }
+} // end namespace async
+
+#endif /* comm_progress_hpp */
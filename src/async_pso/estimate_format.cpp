@@ -0,0 +1,72 @@
+//
+//  estimate_format.cpp
+//  async_pso
+//
+
+#include <cstring>
+#include "estimate_format.hpp"
+
+namespace async {
+    namespace pso {
+        namespace estimate_format {
+            
+            static_assert(sizeof(header_t) == 32, "estimate header must not be padded");
+            
+            // get the number of bytes for each position value
+            static size_t value_size(uint8_t enc) {
+                return enc == Float32 ? sizeof(float) : sizeof(double);
+            }
+            
+            // get the number of bytes needed for an estimate
+            size_t byte_content(size_t dim, encoding_t enc) {
+                return sizeof(header_t) + dim*value_size(enc);
+            }
+            
+            // write an estimate into the buffer
+            size_t serialize(header_t header, const double* position, unsigned char* buffer) {
+                const size_t dim = header.dim;
+                const encoding_t enc = static_cast<encoding_t>(header.encoding);
+                header.version  = version;
+                header.reserved = 0;
+                std::memcpy(buffer, &header, sizeof(header));
+                
+                // copy the position in bulk, or narrow it to floats
+                unsigned char* pos = buffer + sizeof(header);
+                if( enc == Float64 ){
+                    std::memcpy(pos, position, dim*sizeof(double));
+                }else{
+                    for(size_t i = 0; i < dim; ++i){
+                        float value = static_cast<float>(position[i]);
+                        std::memcpy(pos + i*sizeof(float), &value, sizeof(float));
+                    }
+                }
+                
+                return byte_content(dim, enc);
+            }
+            
+            // read the header of an estimate
+            bool deserialize_header(header_t& header, const unsigned char* buffer, size_t size) {
+                if( size < sizeof(header) ){ return false; }
+                std::memcpy(&header, buffer, sizeof(header));
+                if( header.version != version ){ return false; }
+                if( header.encoding != Float64 && header.encoding != Float32 ){ return false; }
+                return size >= sizeof(header) + header.dim*value_size(header.encoding);
+            }
+            
+            // read the position of an estimate
+            void deserialize_position(const header_t& header, const unsigned char* buffer, double* position) {
+                const unsigned char* pos = buffer + sizeof(header);
+                if( header.encoding == Float64 ){
+                    std::memcpy(position, pos, header.dim*sizeof(double));
+                }else{
+                    float value = 0.0f;
+                    for(size_t i = 0; i < header.dim; ++i){
+                        std::memcpy(&value, pos + i*sizeof(float), sizeof(float));
+                        position[i] = value;
+                    }
+                }
+            }
+            
+        }
+    }
+} // end namespace async
@@ -0,0 +1,72 @@
+//
+//  estimate_format.hpp
+//  async_pso
+//
+
+#ifndef estimate_format_hpp
+#define estimate_format_hpp
+
+#include <cstddef>
+#include <cstdint>
+
+namespace async {
+    namespace pso {
+        
+        /*
+         Wire format for a global best estimate, made of a fixed
+         32 byte header followed by the position stored contiguously
+         as either doubles or floats:
+         
+            [version:u8][encoding:u8][reserved:u16][dim:u32][fval:f64]
+            [origin_time:f64][origin_rank:i32][hops:u32][position]
+         
+         The origin is the rank that found the estimate and the time
+         it did so, on the clock of rank 0 that all ranks align to,
+         and hops the number of ranks it went through.
+         
+         The whole estimate is sized up front and written in one pass,
+         so building a message costs one bulk copy of the position.
+         */
+        namespace estimate_format {
+            
+            // current version of the format
+            static const uint8_t version = 2;
+            
+            // how the position is stored
+            enum encoding_t: uint8_t {
+                Float64 = 0,
+                Float32
+            };
+            
+            // fixed header at the start of every estimate
+            struct header_t {
+                uint8_t     version;
+                uint8_t     encoding;
+                uint16_t    reserved;
+                uint32_t    dim;
+                double      fval;
+                double      origin_time;
+                int32_t     origin_rank;
+                uint32_t    hops;
+            };
+            
+            // get the number of bytes needed for an estimate
+            size_t byte_content(size_t dim, encoding_t enc);
+            
+            // write an estimate with the given header, whose version is
+            // filled in, into the buffer and return the number of bytes written
+            size_t serialize(header_t header, const double* position, unsigned char* buffer);
+            
+            // read the header of an estimate of the given size in bytes.
+            // Returns false if the version or size do not match up
+            bool deserialize_header(header_t& header, const unsigned char* buffer, size_t size);
+            
+            // read the position of an estimate into position,
+            // which must have room for header.dim values
+            void deserialize_position(const header_t& header, const unsigned char* buffer, double* position);
+            
+        }
+    }
+} // end namespace async
+
+#endif /* estimate_format_hpp */
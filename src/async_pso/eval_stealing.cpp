@@ -0,0 +1,260 @@
+//
+//  eval_stealing.cpp
+//  async_pso
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "eval_stealing.hpp"
+
+namespace async {
+    namespace pso {
+        
+        // ctor/dtor
+        steal_manager::steal_manager():block(nullptr), fvals(nullptr), chunk_size(1), nchunks_out(0),
+        has_work(false), work_rank(-1), work_chunk(0), work_num(0), ngiven(0), ntaken(0),
+        in_barrier(false), barrier(MPI_REQUEST_NULL), peers(1)
+        {
+            set_mpi_comm(MPI_COMM_WORLD);
+        }
+        
+        // set the communicator
+        void steal_manager::set_mpi_comm(MPI_Comm com) {
+            distributed::msg_manager2::set_mpi_comm(com);
+            int size = 1;
+            MPI_Comm_size(com, &size);
+            peers.setup(local_rank, size);
+        }
+        
+        // seed the generator used to pick peers
+        void steal_manager::set_seed(unsigned seed) {
+            eng.seed(seed);
+        }
+        
+        // attach the block whose positions are handed out
+        void steal_manager::attach(::pso::particle_block& block_) {
+            block = &block_;
+        }
+        
+        // queue up the evaluations of an iteration
+        void steal_manager::begin_iteration(size_t chunk_size_, double* fvals_) {
+            std::lock_guard<std::mutex> lk(lock);
+            chunk_size  = chunk_size_;
+            fvals       = fvals_;
+            const size_t nchunks = (block->size() + chunk_size - 1) / chunk_size;
+            pending.clear();
+            for(size_t c = 0; c < nchunks; ++c){ pending.push_back(c); }
+        }
+        
+        // pop the next chunk of local evaluations
+        bool steal_manager::next_chunk(size_t& first, size_t& last) {
+            std::lock_guard<std::mutex> lk(lock);
+            if( pending.empty() ){ return false; }
+            const size_t c = pending.front();
+            pending.pop_front();
+            first   = c * chunk_size;
+            last    = std::min(first + chunk_size, block->size());
+            return true;
+        }
+        
+        // get the number of chunks handed out to other ranks
+        size_t steal_manager::num_chunks_out() const {
+            std::lock_guard<std::mutex> lk(lock);
+            return nchunks_out;
+        }
+        
+        // make progress on messages
+        void steal_manager::progress(bool may_request) {
+            check_message_completeness();
+            if( num_messages() ){
+                if( all_messages_complete() ){ load_response(); }
+            }else if( may_request && !has_work ){
+                send_request();
+            }
+        }
+        
+        // get work taken from another rank
+        bool steal_manager::has_stolen_work() const {
+            return has_work;
+        }
+        size_t steal_manager::num_stolen_points() const {
+            return work_num;
+        }
+        const double* steal_manager::stolen_positions() const {
+            return work_x.data();
+        }
+        double* steal_manager::stolen_values() {
+            return work_f.data();
+        }
+        
+        // send the values of the stolen work back to its owner
+        void steal_manager::return_stolen_work() {
+            if( !has_work ){ return; }
+            
+            uniq_msg_t msg_ = create_indep_message();
+            msg_->set_destination_rank(work_rank)
+            .set_msg_type(ReturnValues)
+            .set_synchronous(true);
+            
+            metadata_t mdata;
+            mdata.is_response = false;
+            mdata.mngr_id   = manager_id;
+            mdata.msg_id    = 0;
+            mdata.msg_type  = ReturnValues;
+            
+            const uint64_t num = work_num;
+            byte_t* buf = msg_->reserve_send_buffer(metadata_byte_content() + 2*sizeof(uint64_t) + work_num*sizeof(double));
+            size_t offset = serialize_metadata(mdata, buf);
+            offset = util::serialize(work_chunk, buf, offset);
+            offset = util::serialize(num, buf, offset);
+            std::memcpy(buf + offset, work_f.data(), work_num*sizeof(double));
+            send_indep_message(msg_);
+            
+            has_work = false;
+            ++ntaken;
+        }
+        
+        // make progress on shutting down
+        bool steal_manager::drain() {
+            progress(false);
+            
+            // a rank is done once its requests got their responses, the
+            // values it sent back were received and all of its chunks
+            // came back. The barrier completes once every rank got there
+            if( in_barrier ){
+                int done = 0;
+                MPI_Test(&barrier, &done, MPI_STATUS_IGNORE);
+                if( !done ){ return false; }
+                in_barrier = false;
+                while( num_pending_receives() ){ check_message_completeness(); }
+                return true;
+            }
+            if( num_messages() == 0 && num_pending_sends() == 0 && !has_work && num_chunks_out() == 0 ){
+                MPI_Ibarrier(comm, &barrier);
+                in_barrier = true;
+            }
+            return false;
+        }
+        
+        // get the number of chunks given to and taken from others
+        size_t steal_manager::num_given() const {
+            return ngiven;
+        }
+        size_t steal_manager::num_taken() const {
+            return ntaken;
+        }
+        
+        // ask a random peer for work
+        void steal_manager::send_request() {
+            peers.get_destinations(eng, samples);
+            if( samples.empty() ){ return; }
+            
+            size_t mID = create_message();
+            util::raw_handle<distributed::message> msg_ = messages[mID];
+            msg_->set_destination_rank(samples[0])
+            .set_msg_type(StealRequest)
+            .set_synchronous(true);
+            
+            metadata_t mdata;
+            mdata.is_response = false;
+            mdata.mngr_id   = manager_id;
+            mdata.msg_id    = mID;
+            mdata.msg_type  = StealRequest;
+            byte_t* buf = msg_->reserve_send_buffer(metadata_byte_content());
+            serialize_metadata(mdata, buf);
+            
+            send_message(mID);
+        }
+        
+        // take in the work handed over by a peer, if any
+        void steal_manager::load_response() {
+            auto msg_ = get_message_at(0);
+            const byte_t* buf = msg_->get_receive_buffer();
+            const size_t size = msg_->get_receive_buffer_size();
+            uint64_t num = 0, dim = 0;
+            size_t offset = 0;
+            if( size >= 3*sizeof(uint64_t) ){
+                offset = util::deserialize(work_chunk, buf);
+                offset = util::deserialize(num, buf, offset);
+                offset = util::deserialize(dim, buf, offset);
+            }
+            
+            // only take work whose positions are all there
+            // and have the dimension evaluated here
+            const uint64_t ndim = block ? block->num_dims() : 0;
+            if( num > 0 && dim == ndim && size >= offset + num*dim*sizeof(double) ){
+                work_num    = num;
+                work_rank   = msg_->get_dest_rank();
+                work_x.resize(num*dim);
+                work_f.resize(num);
+                std::memcpy(work_x.data(), buf + offset, num*dim*sizeof(double));
+                has_work = true;
+            }
+            clear_messages();
+        }
+        
+        // overloaded response handler
+        void steal_manager::response_handler(byte_t* buf, size_t size, metadata_t metadata, int src_rank) {
+            
+            // take in values for a chunk another rank evaluated
+            if( metadata.msg_type == ReturnValues ){
+                uint64_t chunk = 0, num = 0;
+                size_t offset = 0;
+                if( size >= 2*sizeof(uint64_t) ){
+                    offset = util::deserialize(chunk, buf);
+                    offset = util::deserialize(num, buf, offset);
+                }
+                
+                // values that are not all there or fall outside of the
+                // block are dropped, but the chunk still counts as back
+                const size_t first = chunk * chunk_size;
+                if( block == nullptr || size < offset + num*sizeof(double)
+                   || first + num > block->size() ){ num = 0; }
+                for(size_t k = 0; k < num; ++k){
+                    double fval = 0.0;
+                    offset = util::deserialize(fval, buf, offset);
+                    fvals[first + k] = fval;
+                    block->set_function_value(first + k, fval);
+                }
+                std::lock_guard<std::mutex> lk(lock);
+                --nchunks_out;
+                return;
+            }
+            
+            // hand over the chunk at the back of the queue, as long as
+            // that still leaves some local work, or nothing at all
+            uint64_t chunk = 0, num = 0, first = 0;
+            {
+                std::lock_guard<std::mutex> lk(lock);
+                if( block != nullptr && pending.size() > 1 ){
+                    chunk = pending.back();
+                    pending.pop_back();
+                    first = chunk * chunk_size;
+                    num   = std::min(first + chunk_size, static_cast<uint64_t>(block->size())) - first;
+                    ++nchunks_out;
+                    ++ngiven;
+                }
+            }
+            const uint64_t dim = block ? block->num_dims() : 0;
+            
+            uniq_msg_t msg_ = create_indep_message();
+            msg_->set_destination_rank(src_rank)
+            .set_synchronous(true);
+            metadata.is_response = true;
+            metadata.msg_type = RespondToRequest;
+            
+            byte_t* out = msg_->reserve_send_buffer(metadata_byte_content() + 3*sizeof(uint64_t) + num*dim*sizeof(double));
+            size_t offset = serialize_metadata(metadata, out);
+            offset = util::serialize(chunk, out, offset);
+            offset = util::serialize(num, out, offset);
+            offset = util::serialize(dim, out, offset);
+            for(uint64_t k = 0; k < num; ++k){
+                std::memcpy(out + offset, block->position(first + k), dim*sizeof(double));
+                offset += dim*sizeof(double);
+            }
+            send_indep_message(msg_);
+        }
+        
+    }
+} // end namespace async
@@ -0,0 +1,128 @@
+//
+//  eval_stealing.hpp
+//  async_pso
+//
+
+#ifndef eval_stealing_hpp
+#define eval_stealing_hpp
+
+#include <deque>
+#include <mutex>
+#include <random>
+#include <vector>
+#include "../distr_utility/message_manager2.hpp"
+#include "../particle/particle_block.hpp"
+#include "topology.hpp"
+
+namespace async {
+    namespace pso {
+        
+        /*
+         Class letting ranks evaluate the objective for particles
+         owned by other ranks. The evaluations of an iteration are
+         queued up in chunks that the local threads pop from the
+         front. A rank with no work left asks a random peer for some,
+         and the peer hands over the chunk at the back of its queue,
+         as long as it has more than one left. The thief evaluates
+         the positions and sends the values back, and the owner only
+         finishes its iteration once every chunk it handed out came
+         back. Particles never change owner, so their state stays put.
+         */
+        class steal_manager : public distributed::msg_manager2 {
+        public:
+            
+            // ctor/dtor
+            steal_manager();
+            ~steal_manager() = default;
+            
+            // set the communicator
+            void set_mpi_comm(MPI_Comm comm);
+            
+            // seed the generator used to pick peers
+            void set_seed(unsigned seed);
+            
+            // attach the block whose positions are handed out
+            void attach(::pso::particle_block& block);
+            
+            // queue up the evaluations of an iteration, whose
+            // values go into fvals[0 .. block size)
+            void begin_iteration(size_t chunk_size, double* fvals);
+            
+            // pop the next chunk [first, last) of local evaluations,
+            // which is safe to call from several threads at once
+            bool next_chunk(size_t& first, size_t& last);
+            
+            // get the number of chunks handed out to other
+            // ranks whose values have not come back yet
+            size_t num_chunks_out() const;
+            
+            // make progress on messages, asking a peer for work if
+            // allowed and nothing is in flight or waiting to be done
+            void progress(bool may_request);
+            
+            // get work taken from another rank, stored as a
+            // num x dim row-major matrix, and send the values back
+            bool has_stolen_work() const;
+            size_t num_stolen_points() const;
+            const double* stolen_positions() const;
+            double* stolen_values();
+            void return_stolen_work();
+            
+            // make progress on shutting down, where stolen work must
+            // still be evaluated between calls. Returns true once
+            // every rank is done. Collective over the communicator
+            bool drain();
+            
+            // get the number of chunks given to and taken from others
+            size_t num_given() const;
+            size_t num_taken() const;
+            
+        private:
+            
+            // message types
+            enum msg_type: int {
+                StealRequest = 0,
+                RespondToRequest,
+                ReturnValues
+            };
+            
+            // local queue of chunks
+            ::pso::particle_block*  block;
+            double*                 fvals;
+            size_t                  chunk_size, nchunks_out;
+            std::deque<size_t>      pending;
+            mutable std::mutex      lock;
+            
+            // work taken from another rank
+            bool                    has_work;
+            int                     work_rank;
+            uint64_t                work_chunk;
+            size_t                  work_num;
+            std::vector<double>     work_x, work_f;
+            
+            // counters and shutdown state
+            size_t                  ngiven, ntaken;
+            bool                    in_barrier;
+            MPI_Request             barrier;
+            
+            // peer selection
+            random_topology         peers;
+            std::vector<int>        samples;
+            std::mt19937            eng;
+            
+            // type aliases
+            using byte_t = distributed::byte_t;
+            using metadata_t = distributed::msg_manager2::metadata_t;
+            
+            // overloaded response handler
+            void response_handler(byte_t* buf, size_t size, metadata_t metadata, int src_rank);
+            
+            // ask a random peer for work and take in its response
+            void send_request();
+            void load_response();
+            
+        };
+    }
+} // end namespace async
+
+#endif /* eval_stealing_hpp */
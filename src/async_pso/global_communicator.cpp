@@ -6,14 +6,22 @@
 //  Copyright © 2019 Christian Howard. All rights reserved.
 //
 
+#include <cmath>
 #include <limits>
 #include "global_communicator.hpp"
+#include "../distr_utility/clock_sync.hpp"
 
 namespace async {
     namespace pso {
             
         // ctor/dtor
-        global_comm::global_comm():best_fval(std::numeric_limits<double>::max()),eng(nullptr) {
+        global_comm::global_comm():best_fval(std::numeric_limits<double>::max()),
+        best_origin_time(0.0), best_origin_rank(-1), best_hops(0), best_rounded(false), clock_skew(0.0),
+        topo(new random_topology()), encoding(estimate_format::Float64),
+        backend(TwoSided), share_node(false), send_policy(Periodic),
+        improve_tol(1e-6), min_send_interval(0.0), heartbeat_interval(1.0),
+        last_sent_fval(std::numeric_limits<double>::max()), last_send_time(0.0), profiler(nullptr)
+        {
             set_num_scatter(5);
             set_mpi_comm(MPI_COMM_WORLD);
         }
@@ -21,56 +29,124 @@ namespace async {
         // set the number of processors we will send messages to
         // without replacement
         void global_comm::set_num_scatter(int k) {
-            num_sample = k;
-            
-            // resize the samples list
-            samples.resize(num_sample);
+            num_scatter = k;
+            topo->set_fanout(k);
         }
         
+        // set the topology deciding which ranks estimates are sent to
+        void global_comm::set_topology(std::unique_ptr<topology> topo_) {
+            topo = std::move(topo_);
+            topo->set_fanout(num_scatter);
+            topo->setup(local_rank, tot_rank);
+        }
+        const topology& global_comm::get_topology() const {
+            return *topo;
+        }
+        
+        // get the destinations for this exchange from the topology
         void global_comm::get_samples() {
-            int n = static_cast<int>(perm_samples.size())-1;
-            for(int i = 0; i < num_sample; ++i){
-                std::uniform_int_distribution<int> U(0, n-i);
-                int idx = U(*eng);
-                samples[i] = perm_samples[idx];
-                std::swap(perm_samples[idx], perm_samples[n - i]);
-            }
+            topo->get_destinations(eng, samples);
+            topo->record_send(samples.size());
+        }
+        
+        // get the time on the clock of rank 0 of the base communicator
+        double global_comm::aligned_time() const {
+            return MPI_Wtime() + clock_skew;
+        }
+        
+        // reset the origin of an estimate
+        void global_comm::reset_origin(int origin_rank) {
+            best_origin_time = aligned_time();
+            best_origin_rank = origin_rank;
+            best_hops        = 0;
+            best_rounded     = false;
         }
         
         void global_comm::set_mpi_comm(MPI_Comm com) {
+            base_comm = com;
+            MPI_Comm_rank(com, &base_rank);
+            set_gossip_comm(com);
+        }
+        void global_comm::set_gossip_comm(MPI_Comm com) {
             distributed::msg_manager2::set_mpi_comm(com);
             
             // get local rank and number of processes
             MPI_Comm_rank(com, &local_rank);
             MPI_Comm_size(com, &tot_rank);
             
-            // fill up the samples list
-            perm_samples.resize(0);
-            for(int i = 0; i < tot_rank; ++i){
-                if( i != local_rank ){
-                    perm_samples.push_back(i);
-                }
-            }// end for i
+            // set up the edges for this rank
+            topo->setup(local_rank, tot_rank);
+        }
+        
+        void global_comm::set_seed(unsigned seed) {
+            eng.seed(seed);
+        }
+        
+        // set/get the exchange backend
+        void global_comm::set_backend(backend_t backend_) {
+            backend = backend_;
+        }
+        typename global_comm::backend_t global_comm::get_backend() const {
+            return backend;
+        }
+        
+        // share estimates between the ranks of a node
+        void global_comm::set_node_sharing(bool share) {
+            share_node = share;
+        }
+        bool global_comm::is_node_leader() const {
+            return !node.is_initialized() || node.is_leader();
+        }
+        
+        // setup/tear down for positions of the given dimension
+        void global_comm::initialize(size_t dim) {
             
-            // change the size of the sample,
-            // if necessary
-            if( num_sample > (tot_rank-1) ){
-                set_num_scatter(tot_rank-1);
+            // align the clocks of all the ranks once, on a private
+            // communicator, so origin times compare across ranks
+            MPI_Comm sync_comm;
+            MPI_Comm_dup(base_comm, &sync_comm);
+            clock_skew = distributed::clock_offset(sync_comm, MPI_Wtime);
+            MPI_Comm_free(&sync_comm);
+            
+            // with node sharing only the node leaders gossip,
+            // and they do so among themselves
+            if( share_node ){
+                node.initialize(base_comm, dim);
+                if( !node.is_leader() ){ return; }
+                set_gossip_comm(node.get_leader_comm());
+            }
+            if( backend == OneSided ){ rma.initialize(comm, dim); }
+        }
+        void global_comm::finalize() {
+            rma.finalize();
+            if( node.is_initialized() ){
+                set_gossip_comm(base_comm);
+                node.finalize();
             }
         }
         
-        void global_comm::set_prng(std::mt19937& gen) {
-            eng = &gen;
+        // set how positions are encoded in outgoing messages
+        void global_comm::set_position_encoding(estimate_format::encoding_t enc) {
+            encoding = enc;
+        }
+        estimate_format::encoding_t global_comm::get_position_encoding() const {
+            return encoding;
         }
         
         void global_comm::update_global_best_est(double func_val, const std::vector<double>& position) {
+            update_global_best_est(func_val, position.data(), position.size());
+        }
+        void global_comm::update_global_best_est(double func_val, const double* position, size_t dim) {
             
-	    if( func_val < best_fval ){
+            // a value evaluated here wins ties with a rounded estimate,
+            // whose position does not quite have the value it came with
+            if( func_val < best_fval || (best_rounded && func_val == best_fval) ){
                 best_fval = func_val;
-                best_pos.resize(position.size());
-                for(size_t i = 0; i < position.size(); ++i){
+                best_pos.resize(dim);
+                for(size_t i = 0; i < dim; ++i){
                     best_pos[i] = position[i];
                 }
+                reset_origin(base_rank);
             }
         }
         
@@ -100,29 +176,159 @@ namespace async {
                 mdata.msg_type  = SendEstimate;
                 
                 // add metadata and main data
-                msg_->add_data(mdata);
-                msg_->add_data(best_fval);
-                msg_->add_data(best_pos);
+                write_estimate(*msg_, mdata);
                 
                 // send the message
-                msg_->send();
+                send_message(mID);
             }
+            mark_sent();
         }
         
         void global_comm::load_responses_update_estimate() {
-            double fval = 0;
             for(size_t i = 0; i < num_messages(); ++i){
                 auto msg_ = get_message_at(i);
-                size_t offset = util::deserialize(fval, msg_->get_receive_buffer());
-                
-                if( fval < best_fval ){
-                    best_fval = fval;
-                    offset = util::deserialize(best_pos, msg_->get_receive_buffer(), offset);
-                }
+                read_estimate(msg_->get_receive_buffer(), msg_->get_receive_buffer_size());
             }// loop over messages
             clear_messages();
         }
         
+        // write the metadata and current estimate into a message
+        void global_comm::write_estimate(distributed::message& msg, const metadata_t& metadata) {
+            ::pso::scoped_phase timer(profiler, ::pso::Serialize);
+            
+            // size the message once, then fill it in a single pass
+            size_t nbytes = metadata_byte_content()
+                            + estimate_format::byte_content(best_pos.size(), encoding);
+            byte_t* buf = msg.reserve_send_buffer(nbytes);
+            
+            estimate_format::header_t header;
+            header.encoding     = encoding;
+            header.dim          = static_cast<uint32_t>(best_pos.size());
+            header.fval         = best_fval;
+            header.origin_time  = best_origin_time;
+            header.origin_rank  = best_origin_rank;
+            header.hops         = best_hops;
+            
+            size_t offset = serialize_metadata(metadata, buf);
+            estimate_format::serialize(header, best_pos.data(), buf + offset);
+        }
+        
+        // update the estimate using one received from another rank
+        void global_comm::read_estimate(const byte_t* buf, size_t size) {
+            ::pso::scoped_phase timer(profiler, ::pso::Serialize);
+            
+            // skip anything malformed or from another format version
+            estimate_format::header_t header;
+            if( !estimate_format::deserialize_header(header, buf, size) ){ return; }
+            
+            if( header.fval < best_fval ){
+                best_fval = header.fval;
+                best_pos.resize(header.dim);
+                estimate_format::deserialize_position(header, buf, best_pos.data());
+                
+                // keep track of where it came from and how long it took
+                best_origin_time = header.origin_time;
+                best_origin_rank = header.origin_rank;
+                best_hops        = header.hops + 1;
+                best_rounded     = header.encoding == estimate_format::Float32;
+                
+                // estimates merged through a window or the node slot were
+                // stamped when merged, not when found, so they are left out
+                if( header.origin_rank >= 0 ){
+                    topo->record_adoption(aligned_time() - best_origin_time, best_hops);
+                }
+            }
+        }
+        
+        // set when estimates get sent out
+        void global_comm::set_send_policy(send_policy_t policy) {
+            send_policy = policy;
+        }
+        typename global_comm::send_policy_t global_comm::get_send_policy() const {
+            return send_policy;
+        }
+        void global_comm::set_improvement_threshold(double rel_threshold) {
+            improve_tol = rel_threshold;
+        }
+        void global_comm::set_min_send_interval(double seconds) {
+            min_send_interval = seconds;
+        }
+        void global_comm::set_heartbeat_interval(double seconds) {
+            heartbeat_interval = seconds;
+        }
+        
+        // check whether the send policy allows a send right now
+        bool global_comm::should_send() const {
+            if( send_policy == Periodic ){ return true; }
+            
+            // rate limit the sends
+            const double elapsed = MPI_Wtime() - last_send_time;
+            if( elapsed < min_send_interval ){ return false; }
+            
+            // send if the estimate improved enough since the last send,
+            // or if nothing went out for a whole heartbeat interval
+            if( best_fval < last_sent_fval ){
+                if( last_sent_fval == std::numeric_limits<double>::max() ){ return true; }
+                if( last_sent_fval - best_fval > improve_tol*std::abs(last_sent_fval) ){ return true; }
+            }
+            return elapsed >= heartbeat_interval;
+        }
+        void global_comm::mark_sent() {
+            last_sent_fval = best_fval;
+            last_send_time = MPI_Wtime();
+        }
+        
+        // make one step of the exchange with the chosen backend
+        void global_comm::exchange_estimates(int num2process) {
+            
+            // merge with the node slot, which is all non-leaders do
+            if( node.is_initialized() ){
+                if( node.merge(best_fval, best_pos) ){ reset_origin(-1); }
+                if( !node.is_leader() ){ return; }
+            }
+            
+            if( backend == OneSided && rma.is_initialized() ){
+                
+                // pick up anything written into our window, then merge
+                // with the sampled ranks and publish what we ended up with
+                bool improved = rma.merge(local_rank, best_fval, best_pos);
+                if( should_send() ){
+                    get_samples();
+                    for(int rank: samples){
+                        improved = rma.merge(rank, best_fval, best_pos) || improved;
+                    }
+                    mark_sent();
+                }
+                rma.merge(local_rank, best_fval, best_pos);
+                if( improved ){ reset_origin(-1); }
+            }else{
+                
+                // check for completeness
+                check_messages(num2process);
+                if( num_messages() ){
+                    if( all_messages_complete() ){
+                        load_responses_update_estimate();
+                    }
+                }else if( should_send() ){
+                    send_global_best_est();
+                }
+            }
+            
+            // hand whatever the leader got from other nodes to its node
+            if( node.is_initialized() ){ node.merge(best_fval, best_pos); }
+        }
+        
+        // check for completed estimate messages
+        void global_comm::check_messages(int num2process) {
+            ::pso::scoped_phase timer(profiler, ::pso::MessageCheck);
+            check_message_completeness(num2process);
+        }
+        
+        // set the profiler the messages are timed in
+        void global_comm::set_profiler(::pso::phase_profiler* prof) {
+            profiler = prof;
+        }
+        
         // get the current best estimates
         double global_comm::best_function_value() const {
             return best_fval;
@@ -132,7 +338,7 @@ namespace async {
         }
         
         // overloaded response handler
-        void global_comm::response_handler(byte_t* buf, metadata_t metadata, int src_rank) {
+        void global_comm::response_handler(byte_t* buf, size_t size, metadata_t metadata, int src_rank) {
             
             // create a new message
             uniq_msg_t msg_ = create_indep_message();
@@ -140,30 +346,17 @@ namespace async {
             
             // set metadata as a response
             metadata.is_response = true;
-            
-            // set the message metadata
             metadata.msg_type = RespondToEstimate;
-            msg_->add_data(metadata);
             
             // extract data to see if we
             // should update the best estimate
-            double fval = 0.0;
-            size_t offset = util::deserialize(fval, buf);
-            
-            if( fval < best_fval ){
-                best_fval = fval;
-                offset = util::deserialize(best_pos, buf, offset);
-            }
-            
-            // add the response data to the message
-            msg_->add_data(best_fval);
-            msg_->add_data(best_pos);
+            read_estimate(buf, size);
             
-            // send the message
-            msg_->send();
+            // add the metadata and response data to the message
+            write_estimate(*msg_, metadata);
             
-            // add the message to the response q
-            add_msg_to_response_queue(msg_);
+            // send the message and add it to the response q
+            send_indep_message(msg_);
             
         }
             
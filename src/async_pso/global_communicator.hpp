@@ -10,8 +10,14 @@
 #define global_communicator_hpp
 
 #include <vector>
+#include <memory>
 #include <random>
 #include "../distr_utility/message_manager2.hpp"
+#include "estimate_format.hpp"
+#include "rma_estimate.hpp"
+#include "node_estimate.hpp"
+#include "topology.hpp"
+#include "../particle/phase_profiler.hpp"
 
 namespace async {
     namespace pso {
@@ -23,24 +29,75 @@ namespace async {
         class global_comm : public distributed::msg_manager2 {
         public:
             
+            // ways of exchanging estimates between ranks
+            enum backend_t: int {
+                TwoSided = 0,   // request/response messages, see msg_manager2
+                OneSided        // passive target RMA on windows, see rma_estimate
+            };
+            
+            // when estimates get sent out
+            enum send_policy_t: int {
+                Periodic = 0,   // whenever the previous exchange is done
+                OnImprovement   // only once the estimate improved, see should_send
+            };
+            
             // ctor/dtor
             global_comm();
             ~global_comm() = default;
             
+            // set/get the exchange backend. Must be the same on all
+            // ranks and set before initialize
+            void set_backend(backend_t backend);
+            backend_t get_backend() const;
+            
+            // share estimates between the ranks of a node through shared
+            // memory, see node_estimate, so only one leader per node
+            // exchanges estimates with other nodes. Must be the same on
+            // all ranks and set before initialize
+            void set_node_sharing(bool share);
+            bool is_node_leader() const;
+            
+            // setup/tear down for positions of the given dimension.
+            // Both are collective over the communicator, and finalize
+            // must be called before MPI_Finalize. initialize also aligns
+            // the clocks of the ranks the origin times of estimates use
+            void initialize(size_t dim);
+            void finalize();
+            
             // set the number of processors we will send messages to
-            // without replacement
+            // without replacement, for topologies picking them at random
             void set_num_scatter(int k = 5);
             
+            // set the topology deciding which ranks estimates are sent
+            // to, which is random_topology by default. Estimates merged
+            // through a window or the node slot do not keep their origin,
+            // so the delay and hop stats leave out estimates that were,
+            // even if they went on by message from there
+            void set_topology(std::unique_ptr<topology> topo);
+            const topology& get_topology() const;
+            
             // set the communicator
             void set_mpi_comm(MPI_Comm comm);
             
-            // set random generator
-            void set_prng(std::mt19937& gen);
+            // seed the generator used to pick message destinations
+            void set_seed(unsigned seed);
+            
+            // set how positions are encoded in outgoing messages. Float32
+            // halves the message size at the cost of rounding the shared
+            // positions, while the function values stay in double precision.
+            // An adopted Float32 estimate thus pairs a rounded position with
+            // the value of the exact one, which the position itself need not
+            // reach. Such estimates are marked as rounded, and a local value
+            // equal to a rounded estimate's replaces it, while a rounded
+            // estimate only replaces a local best with a strictly lower value
+            void set_position_encoding(estimate_format::encoding_t enc);
+            estimate_format::encoding_t get_position_encoding() const;
             
             // try to update the global best estimate
             // by passing in some function value and the
             // corresponding position found
             void update_global_best_est(double func_val, const std::vector<double>& position);
+            void update_global_best_est(double func_val, const double* position, size_t dim);
             
             // method to send a message with the
             // current global best estimate
@@ -51,6 +108,30 @@ namespace async {
             // and best position
             void load_responses_update_estimate();
             
+            // set when estimates get sent out. With OnImprovement an exchange
+            // only sends once the best value dropped by more than the relative
+            // threshold since the last send, at most once per min send interval,
+            // and regardless of improvement once per heartbeat interval
+            void set_send_policy(send_policy_t policy);
+            send_policy_t get_send_policy() const;
+            void set_improvement_threshold(double rel_threshold = 1e-6);
+            void set_min_send_interval(double seconds = 0.0);
+            void set_heartbeat_interval(double seconds = 1.0);
+            
+            // make one step of the exchange with the chosen backend.
+            // For TwoSided this sends the estimate out once all responses
+            // to the previous send came back, while OneSided merges the
+            // estimate directly with the windows of the sampled ranks
+            void exchange_estimates(int num2process = 16);
+            
+            // check for completed estimate messages, timed as the
+            // MessageCheck phase when there is a profiler
+            void check_messages(int num2process = 16);
+            
+            // set the profiler that the message checks and the
+            // serialization of estimates are timed in, if any
+            void set_profiler(::pso::phase_profiler* prof);
+            
             // get the current best estimates
             double best_function_value() const;
             const std::vector<double>& best_position() const;
@@ -58,17 +139,54 @@ namespace async {
         private:
             
             // the number of processors to send the messages to
-            int num_sample, local_rank, tot_rank;
+            int num_scatter, local_rank, tot_rank, base_rank;
             
             // specify the best function value
             // and the best position
             double best_fval;
             std::vector<double> best_pos;
             std::vector<int> samples;
-            std::vector<int> perm_samples;
+            
+            // where and when the best estimate was found, on the
+            // aligned clock, and how many ranks it went through since
+            double      best_origin_time;
+            int         best_origin_rank;
+            uint32_t    best_hops;
+            
+            // whether the best position was rounded to floats on its way
+            // here, so best_fval belongs to the unrounded position
+            bool        best_rounded;
+            
+            // offset of MPI_Wtime on this rank to the one on rank 0
+            // of the base communicator, found at initialize
+            double      clock_skew;
+            
+            // topology picking the destinations
+            std::unique_ptr<topology> topo;
             
             // random sampler
-            std::mt19937* eng;
+            std::mt19937 eng;
+            
+            // encoding of positions in outgoing messages
+            estimate_format::encoding_t encoding;
+            
+            // exchange backend and the window used by OneSided
+            backend_t       backend;
+            rma_estimate    rma;
+            
+            // node level sharing, where gossip happens on the leader
+            // communicator and base_comm is the one set by the user
+            bool            share_node;
+            node_estimate   node;
+            MPI_Comm        base_comm;
+            
+            // send policy and the state of the last send
+            send_policy_t   send_policy;
+            double          improve_tol, min_send_interval, heartbeat_interval;
+            double          last_sent_fval, last_send_time;
+            
+            // profiler of the swarm, if any
+            ::pso::phase_profiler* profiler;
             
             // message types
             enum msg_type: int {
@@ -82,11 +200,32 @@ namespace async {
             using metadata_t = distributed::msg_manager2::metadata_t;
             
             // overloaded response handler
-            void response_handler(byte_t* buf, metadata_t metadata, int src_rank);
+            void response_handler(byte_t* buf, size_t size, metadata_t metadata, int src_rank);
             
-            // generate samples without replacement
+            // get the destinations for this exchange from the topology
             void get_samples();
             
+            // check whether the send policy allows a send right now,
+            // and keep track of the estimate that was last sent
+            bool should_send() const;
+            void mark_sent();
+            
+            // get the time on the clock of rank 0 of the base communicator
+            double aligned_time() const;
+            
+            // reset the origin of an estimate that was found locally
+            // or came without one, which is taken to be unrounded
+            void reset_origin(int origin_rank);
+            
+            // set the communicator used for the gossip
+            void set_gossip_comm(MPI_Comm comm);
+            
+            // write the metadata and current estimate into a message
+            void write_estimate(distributed::message& msg, const metadata_t& metadata);
+            
+            // update the estimate using one received from another rank
+            void read_estimate(const byte_t* buf, size_t size);
+            
         };
     }
 } // end namespace async
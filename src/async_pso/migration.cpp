@@ -0,0 +1,219 @@
+//
+//  migration.cpp
+//  async_pso
+//
+
+#include <algorithm>
+#include <cstdint>
+#include "migration.hpp"
+
+namespace async {
+    namespace pso {
+        
+        // ctor/dtor
+        migration_manager::migration_manager():tolerance(0.1), min_particles(1), throughput(0.0),
+        block(nullptr), nsent(0), nreceived(0), draining(false), peers(2)
+        {
+            set_mpi_comm(MPI_COMM_WORLD);
+        }
+        
+        // set the communicator
+        void migration_manager::set_mpi_comm(MPI_Comm com) {
+            distributed::msg_manager2::set_mpi_comm(com);
+            int size = 1;
+            MPI_Comm_size(com, &size);
+            peers.setup(local_rank, size);
+        }
+        
+        // seed the generator used to pick peers
+        void migration_manager::set_seed(unsigned seed) {
+            eng.seed(seed);
+        }
+        
+        // settings
+        void migration_manager::set_num_peers(int k) {
+            peers.set_fanout(k);
+        }
+        void migration_manager::set_imbalance_tolerance(double tol) {
+            tolerance = tol;
+        }
+        void migration_manager::set_min_particles(size_t min_particles_) {
+            min_particles = std::max<size_t>(min_particles_, 1);
+        }
+        
+        // attach the block particles are taken from and added to
+        void migration_manager::attach(::pso::particle_block& block_) {
+            block = &block_;
+        }
+        
+        // record the particle evaluations done in some amount of time
+        void migration_manager::record_work(size_t num_evals, double seconds) {
+            if( num_evals == 0 || seconds <= 0.0 ){ return; }
+            const double rate = num_evals / seconds;
+            throughput = throughput > 0.0 ? 0.8*throughput + 0.2*rate : rate;
+        }
+        double migration_manager::get_throughput() const {
+            return throughput;
+        }
+        
+        // make progress on migrations
+        void migration_manager::progress(bool report) {
+            check_message_completeness();
+            if( num_messages() ){
+                if( all_messages_complete() ){ load_responses(); }
+            }else if( report ){
+                send_reports();
+            }
+        }
+        
+        // stop migrating and wait for the particles in flight
+        void migration_manager::finalize() {
+            drain(comm);
+        }
+        void migration_manager::drain(MPI_Comm sync_comm) {
+            draining = true;
+            
+            // a rank is done once its reports got their responses and its
+            // sends were received, which are synchronous for that reason.
+            // The barrier completes once every rank got there
+            MPI_Request barrier = MPI_REQUEST_NULL;
+            bool in_barrier = false;
+            int done = 0;
+            while( !done ){
+                progress(false);
+                if( in_barrier ){
+                    MPI_Test(&barrier, &done, MPI_STATUS_IGNORE);
+                }else if( num_messages() == 0 && num_pending_sends() == 0 ){
+                    MPI_Ibarrier(sync_comm, &barrier);
+                    in_barrier = true;
+                }
+            }
+            
+            // finish any receive that was matched before the barrier finished
+            while( num_pending_receives() ){ check_message_completeness(); }
+            draining = false;
+        }
+        
+        // get the number of particles sent and received so far
+        size_t migration_manager::num_sent() const {
+            return nsent;
+        }
+        size_t migration_manager::num_received() const {
+            return nreceived;
+        }
+        
+        // send out reports to a few random peers
+        void migration_manager::send_reports() {
+            if( block == nullptr || throughput <= 0.0 ){ return; }
+            peers.get_destinations(eng, samples);
+            for(int rank: samples){
+                size_t mID = create_message();
+                util::raw_handle<distributed::message> msg_ = messages[mID];
+                msg_->set_destination_rank(rank)
+                .set_msg_type(LoadReport)
+                .set_synchronous(true);
+                
+                metadata_t mdata;
+                mdata.is_response = false;
+                mdata.mngr_id   = manager_id;
+                mdata.msg_id    = mID;
+                mdata.msg_type  = LoadReport;
+                write_report(*msg_, mdata);
+                
+                send_message(mID);
+            }
+        }
+        
+        // compare this rank against the peers that responded
+        void migration_manager::load_responses() {
+            for(size_t i = 0; i < num_messages(); ++i){
+                auto msg_ = get_message_at(i);
+                if( draining || msg_->get_receive_buffer_size() < 2*sizeof(double) ){ continue; }
+                
+                double rate = 0.0;
+                uint64_t count = 0;
+                size_t offset = util::deserialize(rate, msg_->get_receive_buffer());
+                util::deserialize(count, msg_->get_receive_buffer(), offset);
+                if( rate <= 0.0 ){ continue; }
+                
+                // compare the time per iteration on both ranks
+                const double mine   = block->size() / throughput;
+                const double theirs = count / rate;
+                if( mine <= (1.0 + tolerance)*theirs ){ continue; }
+                
+                // move half of what would even out the two ranks, since
+                // other peers may be moving particles around at the same time
+                const double even = (block->size()*rate - count*throughput) / (rate + throughput);
+                size_t nmove = static_cast<size_t>(0.5*even);
+                nmove = std::min(nmove, block->size() - std::min(block->size(), min_particles));
+                if( nmove ){ ship_particles(msg_->get_dest_rank(), nmove); }
+            }
+            clear_messages();
+        }
+        
+        // write this rank's throughput and particle count into a message
+        void migration_manager::write_report(distributed::message& msg, const metadata_t& metadata) {
+            const uint64_t count = block ? block->size() : 0;
+            byte_t* buf = msg.reserve_send_buffer(metadata_byte_content() + sizeof(double) + sizeof(uint64_t));
+            size_t offset = serialize_metadata(metadata, buf);
+            offset = util::serialize(throughput, buf, offset);
+            util::serialize(count, buf, offset);
+        }
+        
+        // pack up the last particles of the block and send them to a rank
+        void migration_manager::ship_particles(int rank, size_t count) {
+            uniq_msg_t msg_ = create_indep_message();
+            msg_->set_destination_rank(rank)
+            .set_msg_type(Migrate)
+            .set_synchronous(true);
+            
+            metadata_t mdata;
+            mdata.is_response = false;
+            mdata.mngr_id   = manager_id;
+            mdata.msg_id    = 0;
+            mdata.msg_type  = Migrate;
+            
+            const uint64_t count_ = count;
+            const size_t pbytes = block->packed_bytes();
+            byte_t* buf = msg_->reserve_send_buffer(metadata_byte_content() + sizeof(uint64_t) + count*pbytes);
+            size_t offset = serialize_metadata(mdata, buf);
+            offset = util::serialize(count_, buf, offset);
+            for(size_t k = 0; k < count; ++k){
+                const size_t idx = block->size() - 1;
+                offset += block->pack(idx, buf + offset);
+                block->remove(idx);
+            }
+            nsent += count;
+            
+            send_indep_message(msg_);
+        }
+        
+        // overloaded response handler
+        void migration_manager::response_handler(byte_t* buf, size_t size, metadata_t metadata, int src_rank) {
+            
+            // take in migrating particles
+            if( metadata.msg_type == Migrate ){
+                uint64_t count = 0;
+                size_t offset = util::deserialize(count, buf);
+                const size_t pbytes = block ? block->packed_bytes() : 0;
+                if( block == nullptr || size < offset + count*pbytes ){ return; }
+                for(uint64_t k = 0; k < count; ++k){
+                    block->unpack(buf + offset);
+                    offset += pbytes;
+                }
+                nreceived += count;
+                return;
+            }
+            
+            // respond to a load report with our own load
+            uniq_msg_t msg_ = create_indep_message();
+            msg_->set_destination_rank(src_rank)
+            .set_synchronous(true);
+            metadata.is_response = true;
+            metadata.msg_type = RespondToReport;
+            write_report(*msg_, metadata);
+            send_indep_message(msg_);
+        }
+        
+    }
+} // end namespace async
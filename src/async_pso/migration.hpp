@@ -0,0 +1,119 @@
+//
+//  migration.hpp
+//  async_pso
+//
+
+#ifndef migration_hpp
+#define migration_hpp
+
+#include <random>
+#include <vector>
+#include "../distr_utility/message_manager2.hpp"
+#include "../particle/particle_block.hpp"
+#include "topology.hpp"
+
+namespace async {
+    namespace pso {
+        
+        /*
+         Class moving particles from slow ranks to fast ones. Every
+         report period a rank sends its throughput (evaluations per
+         second) and particle count to a few random peers, who respond
+         with their own. If the time per iteration on this rank exceeds
+         the one of a peer by more than the tolerance, part of the
+         difference in particles is packed up and shipped to that peer,
+         keeping each particle's random stream and step.
+         */
+        class migration_manager : public distributed::msg_manager2 {
+        public:
+            
+            // ctor/dtor
+            migration_manager();
+            ~migration_manager() = default;
+            
+            // set the communicator
+            void set_mpi_comm(MPI_Comm comm);
+            
+            // seed the generator used to pick peers
+            void set_seed(unsigned seed);
+            
+            // set the number of peers per report, the relative difference
+            // in time per iteration that is tolerated, and the number of
+            // particles a rank never goes below
+            void set_num_peers(int k = 2);
+            void set_imbalance_tolerance(double tol = 0.1);
+            void set_min_particles(size_t min_particles = 1);
+            
+            // attach the block particles are taken from and added to
+            void attach(::pso::particle_block& block);
+            
+            // record the number of particle evaluations done
+            // in some amount of time
+            void record_work(size_t num_evals, double seconds);
+            double get_throughput() const;
+            
+            // make progress on migrations, sending out a
+            // load report if report is true
+            void progress(bool report);
+            
+            // stop migrating and wait for all the particles in flight
+            // to arrive, with the ranks agreeing on being done through a
+            // barrier on sync_comm, which has to hold the same ranks.
+            // Migrations carry on afterwards. Collective over sync_comm
+            void drain(MPI_Comm sync_comm);
+            
+            // drain the migrations for good. Collective over the communicator
+            void finalize();
+            
+            // get the number of particles sent and received so far
+            size_t num_sent() const;
+            size_t num_received() const;
+            
+        private:
+            
+            // message types
+            enum msg_type: int {
+                LoadReport = 0,
+                RespondToReport,
+                Migrate
+            };
+            
+            // settings
+            double          tolerance;
+            size_t          min_particles;
+            
+            // throughput estimate, as a moving average
+            double          throughput;
+            
+            // particles and counters
+            ::pso::particle_block*  block;
+            size_t                  nsent, nreceived;
+            bool                    draining;
+            
+            // peer selection
+            random_topology         peers;
+            std::vector<int>        samples;
+            std::mt19937            eng;
+            
+            // type aliases
+            using byte_t = distributed::byte_t;
+            using metadata_t = distributed::msg_manager2::metadata_t;
+            
+            // overloaded response handler
+            void response_handler(byte_t* buf, size_t size, metadata_t metadata, int src_rank);
+            
+            // send out reports and act on the responses
+            void send_reports();
+            void load_responses();
+            
+            // write this rank's throughput and particle count into a message
+            void write_report(distributed::message& msg, const metadata_t& metadata);
+            
+            // pack up particles and send them to a rank
+            void ship_particles(int rank, size_t count);
+            
+        };
+    }
+} // end namespace async
+
+#endif /* migration_hpp */
@@ -0,0 +1,139 @@
+//
+//  node_estimate.cpp
+//  async_pso
+//
+
+#include <cstring>
+#include <limits>
+#include <new>
+#include "node_estimate.hpp"
+
+namespace async {
+    namespace pso {
+        
+        static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "the shared slot needs lock free 64 bit atomics");
+        
+        // ctor/dtor
+        node_estimate::node_estimate():node_comm(MPI_COMM_NULL), leader_comm(MPI_COMM_NULL),
+        win(MPI_WIN_NULL), slot(nullptr), data(nullptr), dim(0), node_rank(0), node_size(1),
+        initialized(false)
+        {
+            
+        }
+        
+        // create the communicators and the shared slot
+        void node_estimate::initialize(MPI_Comm comm, size_t dim_) {
+            if( initialized ){ finalize(); }
+            dim = dim_;
+            copy.resize(dim + 1);
+            
+            // split up the ranks by node, with the lowest rank as leader
+            int rank = 0;
+            MPI_Comm_rank(comm, &rank);
+            MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+            MPI_Comm_rank(node_comm, &node_rank);
+            MPI_Comm_size(node_comm, &node_size);
+            MPI_Comm_split(comm, node_rank == 0 ? 0 : MPI_UNDEFINED, rank, &leader_comm);
+            
+            // the leader allocates the slot, everyone else attaches to it
+            MPI_Aint nbytes = 0;
+            if( node_rank == 0 ){
+                nbytes = static_cast<MPI_Aint>(sizeof(slot_t) + (dim + 1)*sizeof(double));
+            }
+            void* base = nullptr;
+            MPI_Win_allocate_shared(nbytes, 1, MPI_INFO_NULL, node_comm, &base, &win);
+            
+            int disp_unit = 0;
+            MPI_Win_shared_query(win, 0, &nbytes, &disp_unit, &base);
+            slot = reinterpret_cast<slot_t*>(base);
+            data = reinterpret_cast<double*>(slot + 1);
+            
+            // fill the slot with an empty estimate
+            if( node_rank == 0 ){
+                new (&slot->seq) std::atomic<uint64_t>(0);
+                slot->dim = dim;
+                data[0] = std::numeric_limits<double>::max();
+                for(size_t i = 1; i <= dim; ++i){ data[i] = 0.0; }
+            }
+            MPI_Barrier(node_comm);
+            initialized = true;
+        }
+        
+        // free the communicators and the shared slot
+        void node_estimate::finalize() {
+            if( !initialized ){ return; }
+            MPI_Win_free(&win);
+            if( leader_comm != MPI_COMM_NULL ){ MPI_Comm_free(&leader_comm); }
+            MPI_Comm_free(&node_comm);
+            slot = nullptr;
+            data = nullptr;
+            initialized = false;
+        }
+        
+        bool node_estimate::is_initialized() const {
+            return initialized;
+        }
+        
+        // get info about the node
+        bool node_estimate::is_leader() const {
+            return node_rank == 0;
+        }
+        MPI_Comm node_estimate::get_leader_comm() const {
+            return leader_comm;
+        }
+        int node_estimate::get_node_size() const {
+            return node_size;
+        }
+        
+        // merge an estimate with the one in the node slot
+        bool node_estimate::merge(double& fval, std::vector<double>& position) {
+            read_slot();
+            if( copy[0] < fval ){
+                fval = copy[0];
+                position.assign(copy.begin() + 1, copy.end());
+                return true;
+            }
+            if( fval < copy[0] && position.size() == dim ){
+                write_slot(fval, position);
+            }
+            return false;
+        }
+        
+        // read a consistent copy of the slot
+        void node_estimate::read_slot() {
+            const size_t nbytes = (dim + 1)*sizeof(double);
+            uint64_t before = 0, after = 0;
+            do {
+                // wait out any writer, copy, then make sure
+                // no writer got in while copying
+                do { before = slot->seq.load(std::memory_order_acquire); } while( before & 1 );
+                std::memcpy(copy.data(), data, nbytes);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = slot->seq.load(std::memory_order_relaxed);
+            } while( before != after );
+        }
+        
+        // write the estimate into the slot if it is better
+        bool node_estimate::write_slot(double fval, const std::vector<double>& position) {
+            
+            // take the slot by moving the sequence number to an odd value
+            uint64_t seq = slot->seq.load(std::memory_order_relaxed);
+            do {
+                while( seq & 1 ){ seq = slot->seq.load(std::memory_order_relaxed); }
+            } while( !slot->seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire) );
+            std::atomic_thread_fence(std::memory_order_release);
+            
+            // another rank may have written a better estimate meanwhile
+            bool did_write = fval < data[0];
+            if( did_write ){
+                data[0] = fval;
+                std::memcpy(data + 1, position.data(), dim*sizeof(double));
+            }
+            
+            // release the slot with the next even sequence number
+            slot->seq.store(seq + 2, std::memory_order_release);
+            return did_write;
+        }
+        
+    }
+} // end namespace async
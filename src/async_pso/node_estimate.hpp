@@ -0,0 +1,79 @@
+//
+//  node_estimate.hpp
+//  async_pso
+//
+
+#ifndef node_estimate_hpp
+#define node_estimate_hpp
+
+#include <mpi.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace async {
+    namespace pso {
+        
+        /*
+         Best estimate shared by all the ranks on a node through a
+         single slot in a shared memory window. The slot is guarded
+         by a sequence lock, so readers never block a writer and
+         never go through MPI. The lowest rank on each node is the
+         node leader, and the leaders get their own communicator
+         for exchanging estimates across nodes.
+         */
+        class node_estimate {
+        public:
+            
+            // ctor/dtor
+            node_estimate();
+            ~node_estimate() = default;
+            
+            // create/free the node and leader communicators along with
+            // the shared slot. Both are collective over the communicator
+            void initialize(MPI_Comm comm, size_t dim);
+            void finalize();
+            bool is_initialized() const;
+            
+            // check whether this rank is its node's leader, and get the
+            // communicator of all the leaders (MPI_COMM_NULL otherwise)
+            bool is_leader() const;
+            MPI_Comm get_leader_comm() const;
+            int get_node_size() const;
+            
+            // merge an estimate with the one in the node slot, leaving the
+            // better of the two in both. Returns true if fval/position
+            // were improved.
+            bool merge(double& fval, std::vector<double>& position);
+            
+        private:
+            
+            // header of the slot, followed by fval and the position
+            struct slot_t {
+                std::atomic<uint64_t>   seq;
+                uint64_t                dim;
+            };
+            
+            // internal state
+            MPI_Comm            node_comm, leader_comm;
+            MPI_Win             win;
+            slot_t*             slot;
+            double*             data;
+            size_t              dim;
+            int                 node_rank, node_size;
+            bool                initialized;
+            std::vector<double> copy;
+            
+            // read a consistent copy of the slot into copy
+            void read_slot();
+            
+            // write the estimate into the slot if it is better than
+            // what the slot holds. Returns false otherwise
+            bool write_slot(double fval, const std::vector<double>& position);
+            
+        };
+    }
+} // end namespace async
+
+#endif /* node_estimate_hpp */
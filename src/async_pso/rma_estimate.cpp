@@ -0,0 +1,80 @@
+//
+//  rma_estimate.cpp
+//  async_pso
+//
+
+#include <limits>
+#include "rma_estimate.hpp"
+
+namespace async {
+    namespace pso {
+        
+        // ctor/dtor
+        rma_estimate::rma_estimate():win(MPI_WIN_NULL), dim(0), initialized(false) {
+            
+        }
+        
+        // create the window
+        void rma_estimate::initialize(MPI_Comm comm, size_t dim_) {
+            if( initialized ){ finalize(); }
+            dim = dim_;
+            remote.resize(dim + 1);
+            
+            // allocate the window and fill it with an empty estimate
+            double* base = nullptr;
+            MPI_Win_allocate(static_cast<MPI_Aint>((dim + 1)*sizeof(double)),
+                             sizeof(double),
+                             MPI_INFO_NULL,
+                             comm,
+                             &base,
+                             &win);
+            base[0] = std::numeric_limits<double>::max();
+            for(size_t i = 1; i <= dim; ++i){ base[i] = 0.0; }
+            
+            // make sure no rank reads a window before it is filled
+            MPI_Barrier(comm);
+            initialized = true;
+        }
+        
+        // free the window
+        void rma_estimate::finalize() {
+            if( !initialized ){ return; }
+            MPI_Win_free(&win);
+            initialized = false;
+        }
+        
+        bool rma_estimate::is_initialized() const {
+            return initialized;
+        }
+        
+        // merge an estimate with the one in the window of a rank
+        bool rma_estimate::merge(int rank, double& fval, std::vector<double>& position) {
+            const int count = static_cast<int>(dim + 1);
+            bool improved = false;
+            
+            MPI_Win_lock(MPI_LOCK_EXCLUSIVE, rank, 0, win);
+            MPI_Get(remote.data(), count, MPI_DOUBLE, rank, 0, count, MPI_DOUBLE, win);
+            MPI_Win_flush(rank, win);
+            
+            if( remote[0] < fval ){
+                
+                // the window holds a better estimate, so take it
+                fval = remote[0];
+                position.assign(remote.begin() + 1, remote.end());
+                improved = true;
+                
+            }else if( fval < remote[0] && position.size() == dim ){
+                
+                // ours is better, so write it into the window. The
+                // buffer must be left alone until the epoch closes
+                remote[0] = fval;
+                for(size_t i = 0; i < dim; ++i){ remote[i+1] = position[i]; }
+                MPI_Put(remote.data(), count, MPI_DOUBLE, rank, 0, count, MPI_DOUBLE, win);
+            }
+            
+            MPI_Win_unlock(rank, win);
+            return improved;
+        }
+        
+    }
+} // end namespace async
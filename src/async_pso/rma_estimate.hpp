@@ -0,0 +1,54 @@
+//
+//  rma_estimate.hpp
+//  async_pso
+//
+
+#ifndef rma_estimate_hpp
+#define rma_estimate_hpp
+
+#include <mpi.h>
+#include <cstddef>
+#include <vector>
+
+namespace async {
+    namespace pso {
+        
+        /*
+         Best estimate exposed by every rank through an MPI window,
+         stored as [fval, x_1, ..., x_dim]. Estimates are merged with
+         passive target epochs, so the rank owning the window never
+         has to take part for another rank to read or improve it.
+         */
+        class rma_estimate {
+        public:
+            
+            // ctor/dtor
+            rma_estimate();
+            ~rma_estimate() = default;
+            
+            // create/free the window. Both are collective
+            // over the communicator
+            void initialize(MPI_Comm comm, size_t dim);
+            void finalize();
+            bool is_initialized() const;
+            
+            // merge an estimate with the one in the window of a rank,
+            // which may be this rank. Within an exclusive lock on that
+            // window, the better of the two estimates is written into
+            // the window and copied back into fval/position.
+            // Returns true if fval/position were improved.
+            bool merge(int rank, double& fval, std::vector<double>& position);
+            
+        private:
+            
+            // internal state
+            MPI_Win             win;
+            size_t              dim;
+            bool                initialized;
+            std::vector<double> remote;
+            
+        };
+    }
+} // end namespace async
+
+#endif /* rma_estimate_hpp */
@@ -10,10 +10,22 @@
 #define swarm_hpp
 
 #include <mpi.h>
-#include <random>
+#include <cstdint>
+#include <string>
 #include <vector>
 #include "global_communicator.hpp"
-#include "../particle/particle.hpp"
+#include "comm_progress.hpp"
+#include "migration.hpp"
+#include "eval_stealing.hpp"
+#include "termination_detector.hpp"
+#include "cache_sharing.hpp"
+#include "../particle/particle_block.hpp"
+#include "../particle/objective_eval.hpp"
+#include "../particle/termination.hpp"
+#include "../particle/checkpoint.hpp"
+#include "../particle/phase_profiler.hpp"
+#include "../threading/work_pool.hpp"
+#include "../threading/task_queue.hpp"
 
 
 namespace async {
@@ -23,6 +35,12 @@ namespace async {
         class swarm {
         public:
             
+            // ways of scheduling the particle evaluations/updates
+            enum update_mode_t: int {
+                Generational = 0,   // evaluate all, then update all
+                PerParticle         // update each particle as soon as it is evaluated
+            };
+            
             //ctor/dtor
             swarm(int num_particles = 20);
             ~swarm() = default;
@@ -30,6 +48,7 @@ namespace async {
             // set the MPI communicator
             void set_print_flag(bool do_print);
             void set_mpi_comm(MPI_Comm com);
+            void set_seed(uint64_t seed);
             void set_tag(int tag);
             
             // set the bounds
@@ -40,18 +59,125 @@ namespace async {
             void set_momentum(double omega);
             void set_particle_weights(double phi_local, double phi_global);
             
+            // split the particles of this rank across a pool of
+            // threads (including the calling one) that work on
+            // chunks of particles. With more than one thread the
+            // objective must be safe to call concurrently.
+            void set_num_threads(int num_threads);
+            void set_chunk_size(size_t particles_per_chunk);
+            
+            // set how incoming messages are serviced while the
+            // objective is being evaluated, see comm_progress
+            void set_progress_mode(comm_progress::mode_t mode);
+            void set_progress_interval(double seconds);
+            
+            // set how estimates are exchanged between ranks, which
+            // must be the same on all ranks, see global_comm
+            void set_exchange_backend(global_comm::backend_t backend);
+            void set_node_sharing(bool share);
+            
+            // only send estimates out once they improved by more than
+            // the relative threshold, with a heartbeat send once per
+            // heartbeat interval, see global_comm::set_send_policy
+            void set_send_on_improvement(double rel_threshold = 1e-6, double heartbeat_interval = 1.0);
+            
+            // move particles from slow ranks to fast ones, with load
+            // reports sent every period iterations (0 turns this off),
+            // see migration_manager. Must be the same on all ranks
+            void set_migration_period(size_t period);
+            migration_manager& get_migration_manager();
+            
+            // let ranks evaluate chunks of particles for other ranks
+            // that are still busy, see steal_manager. Only applies to
+            // the Generational update mode, and must be the same on all ranks
+            void set_eval_stealing(bool enable);
+            steal_manager& get_steal_manager();
+            
+            // look up objective values in a cache of up to capacity
+            // positions (0 turns this off) before calling the objective,
+            // see pso::eval_cache. With share_period > 0 the values computed
+            // on this rank are sent to a few random peers every share_period
+            // iterations, see cache_share_manager. Must be the same on all ranks
+            void set_eval_cache(size_t capacity, double quantum = 0.0, size_t share_period = 0);
+            const ::pso::eval_cache& get_eval_cache() const;
+            cache_share_manager& get_cache_share_manager();
+            
+            // set how particles are scheduled. In PerParticle mode each
+            // particle is updated with the current global best estimate
+            // right after its own evaluation and goes straight back into
+            // a task queue, so there is no barrier between particles. An
+            // iteration then hands out evals_per_particle * num_particles
+            // evaluations in total, with the only wait at its very end.
+            void set_update_mode(update_mode_t mode);
+            void set_async_batch(size_t evals_per_particle);
+            
+            // write a checkpoint of this rank's particles and best estimate
+            // every period iterations (0 turns this off) in the background,
+            // see pso::checkpoint. The ranks agree on each epoch through a
+            // non-blocking reduction, which also commits the epoch before it
+            // once every rank wrote it, and a rank ahead of the others skips
+            // the checkpoints that come due before the last agreement is in.
+            // With migration on, each checkpoint is a rendezvous of all ranks
+            // instead, since the migrations in flight have to be drained for
+            // every particle to be in exactly one file, so every rank waits
+            // on the slowest one every period iterations. Must be set before
+            // initialize, and the same on all ranks
+            void set_checkpointing(const std::string& prefix, size_t period);
+            const ::pso::checkpoint_writer& get_checkpoint_writer() const;
+            
+            // write the message counters and round trip latencies of the
+            // message managers in use to <prefix>.<rank>.comm at finalize
+            // (an empty prefix turns this off), see distributed::comm_stats.
+            // The counters can also be read at any time off of the managers
+            void set_comm_stats_dump(const std::string& prefix);
+            
+            // record the phases of the iterations and every message sent,
+            // received and handled as a timeline in a ring buffer of capacity
+            // events per rank (0 turns this off), written out at finalize as
+            // one Chrome trace file for all ranks, which chrome://tracing and
+            // Perfetto open. Must be the same on all ranks, see
+            // distributed::trace_recorder
+            void set_tracing(const std::string& file_name, size_t capacity = 1 << 16);
+            
             // initialize the swarm
             void initialize();
             
+            // replace the particles and best estimate set up by initialize
+            // with this rank's share of the last committed checkpoint, which
+            // may have been written by a different number of ranks. Returns
+            // false, keeping the initial state, if it can't be read
+            bool restart(const std::string& prefix);
+            
             // perform an iteration
             void iterate();
             
+            // iterate until some rank meets one of the criteria, which
+            // each rank checks against its own state, with the total
+            // evaluations estimated as the local count times the number
+            // of ranks. That rank ends the run for every rank through a
+            // termination_detector, without a blocking collective.
+            // Collective, and returns the reason for the stop
+            ::pso::stop_reason_t run(const ::pso::termination_criteria& criteria);
+            
+            // stop any background communication progress, free the
+            // exchange resources and commit the last checkpoint.
+            // Collective, and must be called before MPI_Finalize
+            void finalize();
+            
             // get the function reference
             func_type& get_objective_func();
             
             // get the global communicator
             global_comm& get_communicator();
             
+            // get the number of iterations done on this rank
+            size_t get_iteration_count() const;
+            
+            // get the time spent in each phase of the iterations on this
+            // rank since initialize, which is only measured in builds with
+            // APSO_PROFILE defined, see pso::phase_profiler::report
+            const ::pso::phase_profiler& get_profiler() const;
+            
             // methods to retrieve the optimal objective
             // function and position for the swarm on this rank
             double get_best_objective_value() const;
@@ -65,7 +191,20 @@ namespace async {
             double w, phi_l, phi_g;
             
             // particles of the swarm
-            std::vector<::pso::particle> particles;
+            size_t                  num_particles;
+            ::pso::particle_block   particles;
+            std::vector<double>     fvals;
+            
+            // thread pool and per thread scratch space
+            size_t                              chunk_size;
+            threading::work_pool                pool;
+            std::vector<std::vector<double>>    xevals;
+            std::vector<std::vector<double>>    gbests;
+            
+            // per particle scheduling
+            update_mode_t                       update_mode;
+            size_t                              async_batch;
+            threading::task_queue               tasks;
             
             // bounds for the domain
             std::vector<double> lb, ub;
@@ -73,16 +212,68 @@ namespace async {
             // objective function
             func_type objective_func;
             
-            // global communicator
-            global_comm gcom;
+            // global communicator and its progress engine
+            global_comm     gcom;
+            comm_progress   progress;
+            
+            // particle migration and evaluation stealing between ranks
+            migration_manager   migration;
+            size_t              migration_period;
+            steal_manager       stealing;
+            bool                do_steal;
+            
+            // stopping criteria and the agreement on a stop
+            ::pso::termination_monitor  monitor;
+            termination_detector        terminator;
+            std::vector<double>         box_lo, box_hi;
+            
+            // cache of objective values and its sharing between ranks
+            ::pso::eval_cache                   cache;
+            std::vector<::pso::cache_scratch>   cache_scratch;
+            cache_share_manager                 cache_share;
+            size_t                              share_period;
+            
+            // checkpoints of the particles, the epoch of the last one
+            // and the communicator the ranks agree on them over
+            ::pso::checkpoint_writer    ckpt_writer;
+            size_t                      ckpt_period, ckpt_epoch;
+            MPI_Comm                    ckpt_comm;
+            
+            // time spent in each phase
+            ::pso::phase_profiler   profiler;
+            
+            // where the message counters get written at finalize
+            std::string     comm_stats_prefix;
+            
+            // timeline of the phases and messages
+            distributed::trace_recorder trace;
+            std::string                 trace_file;
+            size_t                      trace_capacity;
             
             // random number generator
-            std::mt19937 gen;
+            uint64_t            seed;
+            ::pso::counter_rng  rng;
             
             // MPI stuff
             int local_rank;
             MPI_Comm comm;
             
+            // helper methods for performing an iteration
+            void iterate_generational();
+            void iterate_per_particle();
+            void exchange_estimates();
+            ::pso::stop_reason_t check_termination(size_t iterations, size_t num_evals);
+            void evaluate_range(size_t first, size_t last, double* fvals, int tid);
+            void evaluate_chunks();
+            void finish_stolen_work();
+            void evaluate_stolen_work();
+            void migrate_particles();
+            void write_checkpoint();
+            void wait_for_checkpoint_agreement();
+            void finish_checkpoints();
+            void dump_comm_stats() const;
+            void resize_particle_buffers();
+            void resize_thread_buffers();
             
         };
     
@@ -12,6 +12,8 @@
 #define HEADER template<typename func_type>
 #define CLASS swarm<func_type>
 
+#include <algorithm>
+#include <cstdio>
 #include "swarm.hpp"
 
 namespace async {
@@ -19,27 +21,42 @@ namespace async {
         
             
             //ctor/dtor
-        HEADER CLASS::swarm(int num_particles):particles(num_particles), frequency(1),
-        w(0.9),phi_l(0.7), phi_g(0.5), do_print(true)
+        HEADER CLASS::swarm(int num_particles_):num_particles(num_particles_), frequency(1),
+        w(0.9),phi_l(0.7), phi_g(0.5), do_print(true), chunk_size(8), progress(gcom),
+        update_mode(Generational), async_batch(1), migration_period(0), do_steal(false),
+        share_period(0), ckpt_period(0), ckpt_epoch(0), ckpt_comm(MPI_COMM_NULL), trace_capacity(0)
         {
             comm = MPI_COMM_WORLD;
             MPI_Comm_rank(comm, &local_rank);
-            int seed_val = (local_rank*1749 << 4) ^ 17;
-            gen.seed(seed_val);
+            set_seed(17);
             set_tag(0);
-            gcom.set_prng(gen);
-	    //printf("My rank is %i\n", local_rank);
+            gcom.set_profiler(&profiler);
         }
         
         HEADER void CLASS::set_mpi_comm(MPI_Comm com) {
             MPI_Comm_rank(com, &local_rank);
-            gen.seed(local_rank);
             gcom.set_mpi_comm(com);
+            migration.set_mpi_comm(com);
+            stealing.set_mpi_comm(com);
+            terminator.set_mpi_comm(com);
+            cache_share.set_mpi_comm(com);
             comm = com;
         }
         
+        HEADER void CLASS::set_seed(uint64_t seed_) {
+            seed = seed_;
+        }
+        
         HEADER void CLASS::set_tag(int tag) {
             gcom.set_manager_tag(tag);
+            
+            // migration, stealing, termination and cache messages use
+            // offset tags so they never match the estimate messages,
+            // keeping every tag within the 32767 the MPI standard guarantees
+            migration.set_manager_tag(tag + (1 << 12));
+            stealing.set_manager_tag(tag + (2 << 12));
+            terminator.set_tag(tag + (3 << 12));
+            cache_share.set_manager_tag(tag + (4 << 12));
         }
         
         HEADER void CLASS::set_print_flag(bool do_print_) {
@@ -64,62 +81,542 @@ namespace async {
             frequency = freq;
         }
         
+        // set the threads used to work on the particles
+        HEADER void CLASS::set_num_threads(int num_threads) {
+            pool.resize(num_threads);
+        }
+        HEADER void CLASS::set_chunk_size(size_t particles_per_chunk) {
+            chunk_size = particles_per_chunk > 0 ? particles_per_chunk : 1;
+        }
+        
+        // set how incoming messages are serviced
+        HEADER void CLASS::set_progress_mode(comm_progress::mode_t mode) {
+            progress.set_mode(mode);
+        }
+        HEADER void CLASS::set_progress_interval(double seconds) {
+            progress.set_poll_interval(seconds);
+        }
+        
+        // set how estimates are exchanged between ranks
+        HEADER void CLASS::set_exchange_backend(global_comm::backend_t backend) {
+            gcom.set_backend(backend);
+        }
+        HEADER void CLASS::set_node_sharing(bool share) {
+            gcom.set_node_sharing(share);
+        }
+        
+        // move particles from slow ranks to fast ones
+        HEADER void CLASS::set_migration_period(size_t period) {
+            migration_period = period;
+        }
+        HEADER migration_manager& CLASS::get_migration_manager() {
+            return migration;
+        }
+        
+        // let ranks evaluate particles for other ranks
+        HEADER void CLASS::set_eval_stealing(bool enable) {
+            do_steal = enable;
+        }
+        HEADER steal_manager& CLASS::get_steal_manager() {
+            return stealing;
+        }
+        
+        // look up objective values in a cache
+        HEADER void CLASS::set_eval_cache(size_t capacity, double quantum, size_t share_period_) {
+            cache.set_capacity(capacity);
+            cache.set_quantum(quantum);
+            share_period = capacity ? share_period_ : 0;
+            cache.set_sharing(share_period > 0);
+        }
+        HEADER const ::pso::eval_cache& CLASS::get_eval_cache() const {
+            return cache;
+        }
+        HEADER cache_share_manager& CLASS::get_cache_share_manager() {
+            return cache_share;
+        }
+        
+        // write checkpoints in the background
+        HEADER void CLASS::set_checkpointing(const std::string& prefix, size_t period) {
+            ckpt_writer.set_prefix(prefix);
+            ckpt_period = period;
+        }
+        HEADER const ::pso::checkpoint_writer& CLASS::get_checkpoint_writer() const {
+            return ckpt_writer;
+        }
+        
+        // write the message counters at finalize
+        HEADER void CLASS::set_comm_stats_dump(const std::string& prefix) {
+            comm_stats_prefix = prefix;
+        }
+        
+        // record the phases and messages as a timeline
+        HEADER void CLASS::set_tracing(const std::string& file_name, size_t capacity) {
+            trace_file     = file_name;
+            trace_capacity = file_name.empty() ? 0 : capacity;
+        }
+        
+        // only send estimates out once they improved
+        HEADER void CLASS::set_send_on_improvement(double rel_threshold, double heartbeat_interval) {
+            gcom.set_send_policy(global_comm::OnImprovement);
+            gcom.set_improvement_threshold(rel_threshold);
+            gcom.set_heartbeat_interval(heartbeat_interval);
+        }
+        
+        // set how particles are scheduled
+        HEADER void CLASS::set_update_mode(update_mode_t mode) {
+            update_mode = mode;
+        }
+        HEADER void CLASS::set_async_batch(size_t evals_per_particle) {
+            async_batch = evals_per_particle > 0 ? evals_per_particle : 1;
+        }
+        
         // initialize the swarm
         HEADER void CLASS::initialize() {
             counter = 0;
             size_t dim = lb.size();
-	    int idx = 0;
-            for(auto&p: particles){
-                p.set_num_dims(dim);
-                p.initialize( gen, lb, ub );
-                p.set_momentum(w);
-                p.set_particle_weights(phi_l, phi_g);
-            }
+            fvals.resize(num_particles);
+            particles.resize(num_particles, dim);
+            particles.set_momentum(w);
+            particles.set_particle_weights(phi_l, phi_g);
+            
+            // each particle draws from its own stream, keyed by
+            // the rank and its local index, so the samples are
+            // reproducible per (rank, particle, iteration)
+            rng.set_seed(seed);
+            gcom.set_seed(static_cast<unsigned>(seed) ^ (static_cast<unsigned>(local_rank)*1749u << 4));
+            migration.set_seed(static_cast<unsigned>(seed) ^ (static_cast<unsigned>(local_rank)*7919u << 4));
+            migration.attach(particles);
+            stealing.set_seed(static_cast<unsigned>(seed) ^ (static_cast<unsigned>(local_rank)*4111u << 4));
+            stealing.attach(particles);
+            cache_share.set_seed(static_cast<unsigned>(seed) ^ (static_cast<unsigned>(local_rank)*6133u << 4));
+            cache_share.attach(cache, dim);
+            particles.set_stream_ids(static_cast<uint64_t>(local_rank) << 32);
+            particles.initialize( rng, lb, ub );
+            resize_thread_buffers();
+            gcom.initialize(dim);
+            profiler.reset();
+            
+            // checkpoints are agreed on over a communicator of their own,
+            // so they can't get mixed up with the other collectives
+            ckpt_epoch = 0;
+            if( ckpt_period && ckpt_comm == MPI_COMM_NULL ){ MPI_Comm_dup(comm, &ckpt_comm); }
+            
+            // hook the timeline up to the phases and the message managers
+            trace.enable(trace_capacity);
+            distributed::trace_recorder* rec = trace_capacity ? &trace : nullptr;
+            profiler.set_tracer(rec);
+            gcom.set_tracer(rec, "estimates");
+            migration.set_tracer(rec, "migration");
+            stealing.set_tracer(rec, "stealing");
+            cache_share.set_tracer(rec, "cache sharing");
+            
+            // queue up all the particles for per particle scheduling
+            tasks.clear();
+            for(size_t k = 0; k < particles.size(); ++k){ tasks.push(k); }
+            
+            // start servicing messages in the background, if requested
+            progress.start();
+        }
+        
+        // replace the initial state with a checkpoint
+        HEADER bool CLASS::restart(const std::string& prefix) {
+            int tot_ranks = 1;
+            MPI_Comm_size(comm, &tot_ranks);
+            
+            ::pso::checkpoint::state_t state;
+            if( !::pso::checkpoint::read(prefix, local_rank, tot_ranks, particles, state) ){ return false; }
+            resize_particle_buffers();
+            counter    = state.iteration;
+            ckpt_epoch = state.epoch;
+            
+            // the checkpoints we take from here on replace the ones we read
+            if( prefix == ckpt_writer.get_prefix() ){ ckpt_writer.set_committed(state); }
+            
+            std::lock_guard<std::mutex> lk(progress.get_lock());
+            gcom.update_global_best_est(state.best_fval, state.best_pos);
+            return true;
         }
         
         // perform an iteration
         HEADER void CLASS::iterate() {
-
-            // compute the values of the particles
-            for(auto& p: particles){
-                double fval = objective_func(p.get_current_position());
-                p.set_function_value(fval);
-
-                // set values into the global estimate tracker
-                gcom.update_global_best_est(fval, p.get_current_position());
-            }
+            ::pso::scoped_phase timer(&profiler, ::pso::Iteration);
             
-            // update the particles
-            const std::vector<double>& global_best = gcom.best_position();
-            for(auto& p: particles){
-                
-                // update the particle with the current
-                // global best estimate
-                p.update(global_best);
+            // evaluate and update the particles
+            const double start = MPI_Wtime();
+            if( update_mode == PerParticle ){ iterate_per_particle(); }
+            else{ iterate_generational(); }
+            
+            // rebalance the particles between ranks
+            if( migration_period ){
+                const size_t evals = particles.size() * (update_mode == PerParticle ? async_batch : 1);
+                migration.record_work(evals, MPI_Wtime() - start);
+                migrate_particles();
             }
             
             // send out message and receive results, if necessary
             if( ++counter % frequency == 0 ){
+                ::pso::scoped_phase exchange_timer(&profiler, ::pso::Exchange);
+                std::lock_guard<std::mutex> lk(progress.get_lock());
+                exchange_estimates();
+            }
+            
+            // share the latest objective values
+            if( share_period ){
+                ::pso::scoped_phase share_timer(&profiler, ::pso::CacheShare);
+                std::lock_guard<std::mutex> lk(progress.get_lock());
+                cache_share.progress(counter % share_period == 0);
+            }
+            
+            // checkpoint the particles in the background, and see
+            // whether the ranks agreed on the last checkpoint yet
+            if( ckpt_period ){
+                if( counter % ckpt_period == 0 ){ write_checkpoint(); }
+                else{
+                    std::lock_guard<std::mutex> lk(progress.get_lock());
+                    ckpt_writer.test_agreement();
+                }
+            }
+        }
+        
+        // iterate until some rank meets one of the criteria
+        HEADER ::pso::stop_reason_t CLASS::run(const ::pso::termination_criteria& criteria) {
+            int tot_ranks = 1;
+            MPI_Comm_size(comm, &tot_ranks);
+            
+            monitor.start(criteria);
+            terminator.start();
+            size_t iterations = 0, num_evals = 0;
+            while( !terminator.is_done() ){
+                num_evals += particles.size() * (update_mode == PerParticle ? async_batch : 1);
+                iterate();
+                ++iterations;
                 
-                // check for completeness
-                gcom.check_message_completeness(16);
-                if( gcom.num_messages() ){
-                    if( gcom.all_messages_complete() ){
-                        gcom.load_responses_update_estimate();
+                // keep checking the criteria until some rank decided on a
+                // stop, then keep iterating until every rank went along
+                ::pso::scoped_phase timer(&profiler, ::pso::Termination);
+                std::lock_guard<std::mutex> lk(progress.get_lock());
+                if( !terminator.is_stopping() ){
+                    ::pso::stop_reason_t reason = check_termination(iterations, num_evals * tot_ranks);
+                    if( reason != ::pso::NotStopped ){ terminator.request_stop(reason); }
+                }
+                terminator.progress();
+            }
+            return static_cast<::pso::stop_reason_t>(terminator.get_reason());
+        }
+        
+        // check the criteria against the state of this rank
+        HEADER ::pso::stop_reason_t CLASS::check_termination(size_t iterations, size_t num_evals) {
+            ::pso::stop_reason_t reason = monitor.check(iterations, gcom.best_function_value(), num_evals);
+            if( reason == ::pso::NotStopped && monitor.wants_diameter() ){
+                particles.position_bounds(box_lo, box_hi);
+                reason = monitor.check_diameter(box_lo, box_hi);
+            }
+            return reason;
+        }
+        
+        HEADER void CLASS::iterate_generational() {
+
+            // compute the values of the particles chunk by chunk, with
+            // one call per chunk if the objective supports batch evaluation
+            const size_t nparts  = particles.size();
+            const size_t nchunks = (nparts + chunk_size - 1) / chunk_size;
+            const bool do_poll = progress.get_mode() == comm_progress::Polled;
+            resize_thread_buffers();
+            if( do_steal ){ evaluate_chunks(); }
+            else{
+                pool.parallel_for(nchunks, [&](size_t c, int tid){
+                    size_t first = c * chunk_size;
+                    size_t last  = std::min(first + chunk_size, nparts);
+                    evaluate_range(first, last, &fvals[first], tid);
+                    for(size_t k = first; k < last; ++k){
+                        particles.set_function_value(k, fvals[k]);
                     }
-                }else{
-                    gcom.send_global_best_est();
+                    
+                    // service incoming messages between chunks, which
+                    // only the thread that owns the communicator may do
+                    if( do_poll && tid == 0 ){ progress.poll(); }
+                });
+            }
+            
+            // lock the communicator against the progress thread
+            {
+                ::pso::scoped_phase timer(&profiler, ::pso::BestUpdate);
+                std::lock_guard<std::mutex> lk(progress.get_lock());
+                
+                // find the best particle
+                size_t kbest = 0;
+                for(size_t k = 1; k < nparts; ++k){
+                    if( fvals[k] < fvals[kbest] ){ kbest = k; }
+                }
+                
+                // set values into the global estimate tracker
+                if( nparts ){
+                    gcom.update_global_best_est(fvals[kbest], particles.position(kbest), particles.num_dims());
                 }
                 
-                // print message
-                if( do_print ){
-                    printf("Rank(%i): f_{best} = %0.5e @ [ ", local_rank, gcom.best_function_value());
-                    for(size_t i = 0; i < global_best.size(); ++i){
-                        printf("%0.3e ", global_best[i]);
+                // update the particles with the current global best
+                // estimate, once this rank has particles and an estimate
+                if( !particles.set_global_best(gcom.best_position()) ){ return; }
+            }
+            pool.parallel_for(nchunks, [&](size_t c, int){
+                ::pso::scoped_phase timer(&profiler, ::pso::Update);
+                size_t first = c * chunk_size;
+                particles.update_range(first, std::min(first + chunk_size, nparts));
+            });
+        }
+        
+        // evaluate particles [first, last), through the cache if it is on
+        HEADER void CLASS::evaluate_range(size_t first, size_t last, double* fvals_, int tid) {
+            ::pso::scoped_phase timer(&profiler, ::pso::Evaluate);
+            ::pso::evaluate_particles(objective_func, cache, cache_scratch[tid], particles,
+                                      first, last, fvals_, xevals[tid]);
+        }
+        
+        HEADER void CLASS::evaluate_chunks() {
+            
+            // the threads pop chunks off of the local queue, while other
+            // ranks may take chunks off of the back of it in the meantime
+            const bool do_poll = progress.get_mode() == comm_progress::Polled;
+            stealing.begin_iteration(chunk_size, fvals.data());
+            pool.parallel_for(pool.num_threads(), [&](size_t, int tid){
+                size_t first = 0, last = 0;
+                while( stealing.next_chunk(first, last) ){
+                    evaluate_range(first, last, &fvals[first], tid);
+                    for(size_t k = first; k < last; ++k){
+                        particles.set_function_value(k, fvals[k]);
+                    }
+                    
+                    // hand out work between chunks, on the thread that
+                    // owns the communicators
+                    if( tid == 0 ){
+                        ::pso::scoped_phase timer(&profiler, ::pso::Stealing);
+                        std::lock_guard<std::mutex> lk(progress.get_lock());
+                        stealing.progress(false);
+                        if( do_poll ){ gcom.check_messages(16); }
                     }
-                    printf("]\n");
                 }
+            });
+            
+            finish_stolen_work();
+        }
+        
+        HEADER void CLASS::finish_stolen_work() {
+            
+            // do the work taken from others, and ask for more while
+            // waiting for the values of the chunks others took from us
+            do {
+                {
+                    ::pso::scoped_phase timer(&profiler, ::pso::Stealing);
+                    std::lock_guard<std::mutex> lk(progress.get_lock());
+                    stealing.progress(true);
+                }
+                evaluate_stolen_work();
+            } while( stealing.num_chunks_out() );
+        }
+        
+        HEADER void CLASS::evaluate_stolen_work() {
+            if( !stealing.has_stolen_work() ){ return; }
+            const size_t dim = particles.num_dims();
+            {
+                ::pso::scoped_phase timer(&profiler, ::pso::Evaluate);
+                ::pso::evaluate_points(objective_func, stealing.stolen_positions(), stealing.num_stolen_points(),
+                                       dim, dim, stealing.stolen_values(), xevals[0]);
             }
+            
+            ::pso::scoped_phase timer(&profiler, ::pso::Stealing);
+            std::lock_guard<std::mutex> lk(progress.get_lock());
+            stealing.return_stolen_work();
+        }
+        
+        HEADER void CLASS::iterate_per_particle() {
+            
+            // hand out a budget of evaluations to the threads, where each
+            // thread loops pulling particles off of the task queue
+            const size_t dim     = particles.num_dims();
+            const bool do_poll   = progress.get_mode() == comm_progress::Polled;
+            resize_thread_buffers();
+            tasks.set_budget(particles.size() * async_batch);
+            pool.parallel_for(pool.num_threads(), [&](size_t, int tid){
+                std::vector<double>& gbest = gbests[tid];
+                size_t k = 0;
+                while( tasks.pop(k) ){
+                    
+                    // evaluate the particle
+                    double fval = 0.0;
+                    evaluate_range(k, k+1, &fval, tid);
+                    particles.set_function_value(k, fval);
+                    
+                    // fold the result into the global estimate
+                    // and grab the latest estimate
+                    {
+                        ::pso::scoped_phase timer(&profiler, ::pso::BestUpdate);
+                        std::lock_guard<std::mutex> lk(progress.get_lock());
+                        gcom.update_global_best_est(fval, particles.position(k), dim);
+                        const std::vector<double>& best = gcom.best_position();
+                        std::copy(best.begin(), best.end(), gbest.begin());
+                    }
+                    
+                    // update the particle and send it right back
+                    {
+                        ::pso::scoped_phase timer(&profiler, ::pso::Update);
+                        particles.update_range(k, k+1, gbest.data());
+                    }
+                    tasks.push(k);
+                    
+                    // service incoming messages between evaluations
+                    if( do_poll && tid == 0 ){ progress.poll(); }
+                }
+            });
+        }
+        
+        HEADER void CLASS::exchange_estimates() {
+            
+            // make progress on the exchange
+            gcom.exchange_estimates(16);
+            
+            // print message
+            if( do_print ){
+                const std::vector<double>& global_best = gcom.best_position();
+                printf("Rank(%i): f_{best} = %0.5e @ [ ", local_rank, gcom.best_function_value());
+                for(size_t i = 0; i < global_best.size(); ++i){
+                    printf("%0.3e ", global_best[i]);
+                }
+                printf("]\n");
+            }
+        }
+        
+        HEADER void CLASS::migrate_particles() {
+            ::pso::scoped_phase timer(&profiler, ::pso::Migration);
+            
+            // make progress on migrations, reporting our load once a period
+            {
+                std::lock_guard<std::mutex> lk(progress.get_lock());
+                migration.progress( (counter + 1) % migration_period == 0 );
+            }
+            resize_particle_buffers();
+        }
+        
+        HEADER void CLASS::write_checkpoint() {
+            ::pso::scoped_phase timer(&profiler, ::pso::Checkpoint);
+            int tot_ranks = 1;
+            MPI_Comm_size(comm, &tot_ranks);
+            
+            // without migration the particles stay put, so the snapshot is
+            // taken right away and the ranks agree on it in the background.
+            // A rank ahead of the others skips the checkpoints that come due
+            // before they agreed on the last one rather than wait on them,
+            // and there is no use in taking one once some rank finished
+            if( !migration_period ){
+                std::lock_guard<std::mutex> lk(progress.get_lock());
+                if( !ckpt_writer.test_agreement() ){ return; }
+                const bool take = ckpt_writer.all_taking();
+                ckpt_writer.start_agreement(ckpt_comm, ++ckpt_epoch, false);
+                if( take ){
+                    ckpt_writer.write(local_rank, tot_ranks, particles, ckpt_epoch, counter,
+                                      gcom.best_function_value(), gcom.best_position());
+                }
+                return;
+            }
+            
+            // particles in flight would end up in no file of the epoch or
+            // in two, so the ranks agree on the checkpoint and settle the
+            // migrations before the snapshot, unless some rank finished
+            {
+                std::lock_guard<std::mutex> lk(progress.get_lock());
+                ckpt_writer.start_agreement(ckpt_comm, ++ckpt_epoch, false);
+            }
+            wait_for_checkpoint_agreement();
+            if( !ckpt_writer.all_taking() ){ return; }
+            
+            std::lock_guard<std::mutex> lk(progress.get_lock());
+            migration.drain(ckpt_comm);
+            resize_particle_buffers();
+            ckpt_writer.write(local_rank, tot_ranks, particles, ckpt_epoch, counter,
+                              gcom.best_function_value(), gcom.best_position());
+        }
+        
+        // wait for the agreement on the last checkpoint, where ranks
+        // still iterating may wait on the values of work we took from
+        // them, or hand us work, before they get to their part of it
+        HEADER void CLASS::wait_for_checkpoint_agreement() {
+            bool done = false;
+            while( !done ){
+                {
+                    std::lock_guard<std::mutex> lk(progress.get_lock());
+                    if( do_steal ){ stealing.progress(false); }
+                    done = ckpt_writer.test_agreement();
+                }
+                if( do_steal ){ evaluate_stolen_work(); }
+            }
+        }
+        
+        // answer the checkpoint agreements of the ranks still iterating
+        // until all of them finished, which commits the last epoch
+        HEADER void CLASS::finish_checkpoints() {
+            if( ckpt_comm == MPI_COMM_NULL ){ return; }
+            wait_for_checkpoint_agreement();
+            do {
+                {
+                    std::lock_guard<std::mutex> lk(progress.get_lock());
+                    ckpt_writer.start_agreement(ckpt_comm, ckpt_epoch, true);
+                }
+                wait_for_checkpoint_agreement();
+            } while( !ckpt_writer.all_finished() );
+            ckpt_writer.finish_agreements(ckpt_comm);
+            MPI_Comm_free(&ckpt_comm);
+        }
+        
+        HEADER void CLASS::resize_particle_buffers() {
+            
+            // particles came or went, so size the buffers
+            // and requeue the particles to match
+            if( particles.size() != num_particles ){
+                num_particles = particles.size();
+                fvals.resize(num_particles);
+                tasks.clear();
+                for(size_t k = 0; k < num_particles; ++k){ tasks.push(k); }
+            }
+        }
+        
+        HEADER void CLASS::resize_thread_buffers() {
+            const size_t nthreads = static_cast<size_t>(pool.num_threads());
+            if( xevals.size() != nthreads ){
+                xevals.assign(nthreads, std::vector<double>(particles.num_dims()));
+                gbests.assign(nthreads, std::vector<double>(particles.stride(), 0.0));
+                cache_scratch.resize(nthreads);
+            }
+        }
+        
+        // stop any background communication progress
+        // and free the exchange resources
+        HEADER void CLASS::finalize() {
+            progress.stop();
+            finish_checkpoints();
+            if( migration_period ){
+                migration.finalize();
+                resize_particle_buffers();
+            }
+            if( do_steal ){
+                while( !stealing.drain() ){ evaluate_stolen_work(); }
+            }
+            if( share_period ){ cache_share.finalize(); }
+            gcom.finalize();
+            dump_comm_stats();
+            if( trace.is_enabled() ){ trace.write(comm, trace_file); }
+        }
+        
+        // write the counters of the message managers in use
+        HEADER void CLASS::dump_comm_stats() const {
+            if( comm_stats_prefix.empty() ){ return; }
+            const std::string name = comm_stats_prefix + "." + std::to_string(local_rank) + ".comm";
+            FILE* out = fopen(name.c_str(), "w");
+            if( !out ){ return; }
+            
+            gcom.print_comm_stats(out, "estimates");
+            if( migration_period ){ migration.print_comm_stats(out, "migration"); }
+            if( do_steal ){ stealing.print_comm_stats(out, "stealing"); }
+            if( share_period ){ cache_share.print_comm_stats(out, "cache sharing"); }
+            fclose(out);
         }
         
         // get the function reference
@@ -132,6 +629,16 @@ namespace async {
             return gcom;
         }
         
+        // get the number of iterations done on this rank
+        HEADER size_t CLASS::get_iteration_count() const {
+            return counter;
+        }
+        
+        // get the time spent in each phase
+        HEADER const ::pso::phase_profiler& CLASS::get_profiler() const {
+            return profiler;
+        }
+        
         HEADER double CLASS::get_best_objective_value() const {
             return gcom.best_function_value();
         }
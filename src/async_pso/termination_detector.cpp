@@ -0,0 +1,102 @@
+//
+//  termination_detector.cpp
+//  async_pso
+//
+
+#include "termination_detector.hpp"
+
+namespace async {
+    namespace pso {
+
+        // ctor/dtor
+        termination_detector::termination_detector():state(Running), reason(0), incoming(0),
+        barrier(MPI_REQUEST_NULL), tag(103)
+        {
+            set_mpi_comm(MPI_COMM_WORLD);
+        }
+
+        // set the communicator and the tag used for notices
+        void termination_detector::set_mpi_comm(MPI_Comm comm_) {
+            comm = comm_;
+            MPI_Comm_rank(comm, &local_rank);
+            MPI_Comm_size(comm, &tot_rank);
+        }
+        void termination_detector::set_tag(int tag_) {
+            tag = tag_;
+        }
+
+        // get ready for a new run
+        void termination_detector::start() {
+            state   = Running;
+            reason  = 0;
+            sends.clear();
+        }
+
+        // decide on a stop for this rank
+        void termination_detector::request_stop(int reason_) {
+            if( state != Running ){ return; }
+            reason = reason_;
+
+            // let every other rank know, where a synchronous send
+            // completes only once the notice was matched
+            sends.assign(tot_rank, MPI_REQUEST_NULL);
+            for(int r = 0; r < tot_rank; ++r){
+                if( r == local_rank ){ continue; }
+                MPI_Issend(&reason, 1, MPI_INT, r, tag, comm, &sends[r]);
+            }
+            state = Notifying;
+        }
+
+        // make progress on the protocol
+        void termination_detector::progress() {
+            receive_notices();
+
+            if( state == Notifying ){
+                int done = 0;
+                MPI_Testall(static_cast<int>(sends.size()), sends.data(), &done, MPI_STATUSES_IGNORE);
+                if( done ){
+                    MPI_Ibarrier(comm, &barrier);
+                    state = Waiting;
+                }
+            }
+            if( state == Waiting ){
+                int done = 0;
+                MPI_Test(&barrier, &done, MPI_STATUS_IGNORE);
+                if( done ){ state = Done; }
+            }
+        }
+
+        // receive any notices that arrived
+        void termination_detector::receive_notices() {
+            int flag = 1;
+            while( flag ){
+                MPI_Status stat;
+                MPI_Iprobe(MPI_ANY_SOURCE, tag, comm, &flag, &stat);
+                if( !flag ){ break; }
+                MPI_Recv(&incoming, 1, MPI_INT, stat.MPI_SOURCE, tag, comm, MPI_STATUS_IGNORE);
+
+                // go along with the first stop we hear about, unless
+                // this rank already decided on one of its own
+                if( state == Running ){
+                    reason = incoming;
+                    MPI_Ibarrier(comm, &barrier);
+                    state = Waiting;
+                }
+            }
+        }
+
+        // check the state of the protocol
+        bool termination_detector::is_stopping() const {
+            return state != Running;
+        }
+        bool termination_detector::is_done() const {
+            return state == Done;
+        }
+
+        // get the reason of the stop
+        int termination_detector::get_reason() const {
+            return reason;
+        }
+
+    }
+} // end namespace async
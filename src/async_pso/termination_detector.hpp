@@ -0,0 +1,81 @@
+//
+//  termination_detector.hpp
+//  async_pso
+//
+
+#ifndef termination_detector_hpp
+#define termination_detector_hpp
+
+#include <mpi.h>
+#include <vector>
+
+namespace async {
+    namespace pso {
+
+        /*
+         Non-blocking agreement on when an asynchronous run stops,
+         where the first rank to decide on a stop ends the run for
+         every rank. That rank sends a stop notice to all the others
+         with synchronous sends, and enters an MPI_Ibarrier once they
+         were all matched. A rank that gets a notice enters the barrier
+         right away. Ranks keep iterating while the protocol runs, and
+         the run is over once the barrier completes, at which point
+         every notice has been received. Nothing blocks along the way.
+         */
+        class termination_detector {
+        public:
+
+            // ctor/dtor
+            termination_detector();
+            ~termination_detector() = default;
+
+            // set the communicator and the tag used for notices
+            void set_mpi_comm(MPI_Comm comm);
+            void set_tag(int tag);
+
+            // get ready for a new run
+            void start();
+
+            // decide on a stop for this rank, with the reason
+            // passed along to the other ranks
+            void request_stop(int reason);
+
+            // make progress on the protocol
+            void progress();
+
+            // check whether a stop was decided on or received,
+            // and whether every rank agreed on it
+            bool is_stopping() const;
+            bool is_done() const;
+
+            // get the reason of the stop this rank went along with
+            int get_reason() const;
+
+        private:
+
+            // states of the protocol
+            enum state_t: int {
+                Running = 0,
+                Notifying,  // waiting on the notices to be matched
+                Waiting,    // waiting on the barrier
+                Done
+            };
+
+            // internal state
+            state_t                     state;
+            int                         reason, incoming;
+            std::vector<MPI_Request>    sends;
+            MPI_Request                 barrier;
+
+            // MPI stuff
+            int         tag, local_rank, tot_rank;
+            MPI_Comm    comm;
+
+            // receive any notices that arrived
+            void receive_notices();
+
+        };
+    }
+} // end namespace async
+
+#endif /* termination_detector_hpp */
@@ -0,0 +1,217 @@
+//
+//  topology.cpp
+//  async_pso
+//
+
+#include <mpi.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "topology.hpp"
+
+namespace async {
+    namespace pso {
+        
+        // add a neighbor unless it is this rank or already there
+        static void add_neighbor(std::vector<int>& neighbors, int rank, int nb) {
+            if( nb == rank ){ return; }
+            if( std::find(neighbors.begin(), neighbors.end(), nb) != neighbors.end() ){ return; }
+            neighbors.push_back(nb);
+        }
+        
+        /*
+         base topology
+         */
+        topology::topology() {
+            reset_stats();
+        }
+        void topology::set_fanout(int) {
+            
+        }
+        
+        // record sends and adoptions
+        void topology::record_send(size_t num_sent) {
+            stats.messages_sent += num_sent;
+        }
+        void topology::record_adoption(double delay, uint32_t hops) {
+            ++stats.num_adopted;
+            stats.total_delay += delay;
+            stats.max_delay    = std::max(stats.max_delay, delay);
+            stats.total_hops  += hops;
+            stats.max_hops     = std::max(stats.max_hops, static_cast<size_t>(hops));
+        }
+        
+        // get/reset the stats
+        const topology_stats& topology::get_stats() const {
+            return stats;
+        }
+        void topology::reset_stats() {
+            stats.messages_sent = stats.num_adopted = 0;
+            stats.total_hops = stats.max_hops = 0;
+            stats.total_delay = stats.max_delay = 0.0;
+        }
+        
+        /*
+         random topology
+         */
+        random_topology::random_topology(int k_):k(k_), num_sample(0) {
+            
+        }
+        void random_topology::setup(int rank, int size) {
+            others.resize(0);
+            for(int i = 0; i < size; ++i){
+                if( i != rank ){ others.push_back(i); }
+            }
+            num_sample = std::min(k, static_cast<int>(others.size()));
+        }
+        void random_topology::set_fanout(int k_) {
+            k = k_;
+            num_sample = std::min(k, static_cast<int>(others.size()));
+        }
+        void random_topology::get_destinations(std::mt19937& eng, std::vector<int>& dest) {
+            
+            // partial Fisher-Yates shuffle of the other ranks
+            int n = static_cast<int>(others.size())-1;
+            dest.resize(num_sample);
+            for(int i = 0; i < num_sample; ++i){
+                std::uniform_int_distribution<int> U(0, n-i);
+                int idx = U(eng);
+                dest[i] = others[idx];
+                std::swap(others[idx], others[n - i]);
+            }
+        }
+        const char* random_topology::name() const {
+            return "random";
+        }
+        
+        /*
+         ring topology
+         */
+        void ring_topology::setup(int rank, int size) {
+            neighbors.resize(0);
+            add_neighbor(neighbors, rank, (rank + size - 1) % size);
+            add_neighbor(neighbors, rank, (rank + 1) % size);
+        }
+        void ring_topology::get_destinations(std::mt19937&, std::vector<int>& dest) {
+            dest = neighbors;
+        }
+        const char* ring_topology::name() const {
+            return "ring";
+        }
+        
+        /*
+         2D torus topology
+         */
+        void torus2d_topology::setup(int rank, int size) {
+            int dims[2] = {0, 0};
+            MPI_Dims_create(size, 2, dims);
+            const int nr = dims[0], nc = dims[1];
+            const int r = rank / nc, c = rank % nc;
+            
+            neighbors.resize(0);
+            add_neighbor(neighbors, rank, ((r + nr - 1) % nr)*nc + c);
+            add_neighbor(neighbors, rank, ((r + 1) % nr)*nc + c);
+            add_neighbor(neighbors, rank, r*nc + (c + nc - 1) % nc);
+            add_neighbor(neighbors, rank, r*nc + (c + 1) % nc);
+        }
+        void torus2d_topology::get_destinations(std::mt19937&, std::vector<int>& dest) {
+            dest = neighbors;
+        }
+        const char* torus2d_topology::name() const {
+            return "torus2d";
+        }
+        
+        /*
+         hypercube topology
+         */
+        void hypercube_topology::setup(int rank, int size) {
+            neighbors.resize(0);
+            for(int bit = 1; bit < size; bit <<= 1){
+                int nb = rank ^ bit;
+                if( nb < size ){ neighbors.push_back(nb); }
+            }
+        }
+        void hypercube_topology::get_destinations(std::mt19937&, std::vector<int>& dest) {
+            dest = neighbors;
+        }
+        const char* hypercube_topology::name() const {
+            return "hypercube";
+        }
+        
+        /*
+         small world topology
+         */
+        small_world_topology::small_world_topology(int k_, double p_, unsigned seed_):k(k_), p(p_), seed(seed_) {
+            
+        }
+        void small_world_topology::setup(int rank, int size) {
+            
+            // every rank rewires its own edges, with a generator
+            // that only depends on the seed and the rank
+            std::mt19937 eng(seed ^ (static_cast<unsigned>(rank)*2654435761u));
+            std::uniform_real_distribution<double> U(0.0, 1.0);
+            std::uniform_int_distribution<int> R(0, std::max(size - 1, 0));
+            
+            neighbors.resize(0);
+            for(int j = 1; j <= k; ++j){
+                int lattice[2] = { (rank + j) % size, (rank + size - (j % size)) % size };
+                for(int nb: lattice){
+                    if( size > 2 && U(eng) < p ){ nb = R(eng); }
+                    add_neighbor(neighbors, rank, nb);
+                }
+            }
+        }
+        void small_world_topology::get_destinations(std::mt19937&, std::vector<int>& dest) {
+            dest = neighbors;
+        }
+        const char* small_world_topology::name() const {
+            return "small_world";
+        }
+        
+        /*
+         graph topology
+         */
+        graph_topology::graph_topology(const std::string& filename_):filename(filename_), loaded(false) {
+            
+        }
+        void graph_topology::setup(int rank, int size) {
+            neighbors.resize(0);
+            std::ifstream file(filename);
+            loaded = file.good();
+            if( !loaded ){
+                fprintf(stderr, "Rank(%i): can't read the graph topology file '%s', "
+                        "sending to random ranks instead\n", rank, filename.c_str());
+                fallback.setup(rank, size);
+                return;
+            }
+            
+            std::string line;
+            while( std::getline(file, line) ){
+                if( line.empty() || line[0] == '#' ){ continue; }
+                
+                // only the line for this rank matters
+                std::istringstream iss(line);
+                int src = -1, nb = -1;
+                if( !(iss >> src) || src != rank ){ continue; }
+                while( iss >> nb ){
+                    if( nb >= 0 && nb < size ){ add_neighbor(neighbors, rank, nb); }
+                }
+            }
+        }
+        void graph_topology::set_fanout(int k) {
+            fallback.set_fanout(k);
+        }
+        void graph_topology::get_destinations(std::mt19937& eng, std::vector<int>& dest) {
+            if( !loaded ){ fallback.get_destinations(eng, dest); }
+            else{ dest = neighbors; }
+        }
+        const char* graph_topology::name() const {
+            return loaded ? "graph" : fallback.name();
+        }
+        bool graph_topology::is_loaded() const {
+            return loaded;
+        }
+        
+    }
+} // end namespace async
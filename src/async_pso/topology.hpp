@@ -0,0 +1,160 @@
+//
+//  topology.hpp
+//  async_pso
+//
+
+#ifndef topology_hpp
+#define topology_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace async {
+    namespace pso {
+        
+        // counters describing how estimates move through a topology
+        struct topology_stats {
+            size_t  messages_sent;      // estimates sent to other ranks
+            size_t  num_adopted;        // received estimates better than ours
+            double  total_delay;        // summed time from discovery to adoption
+            double  max_delay;          // largest time from discovery to adoption
+            size_t  total_hops;         // summed ranks passed through before adoption
+            size_t  max_hops;           // most ranks passed through before adoption
+        };
+        
+        /*
+         Base class for the graph that decides which ranks an
+         estimate is sent to. Ranks are the ones of the communicator
+         the estimates are exchanged on, and each rank only needs
+         to know its own outgoing edges.
+         */
+        class topology {
+        public:
+            
+            // ctor/dtor
+            topology();
+            virtual ~topology() = default;
+            
+            // set up the edges for a rank of a communicator of the given size
+            virtual void setup(int rank, int size) = 0;
+            
+            // set the number of destinations per exchange, for
+            // topologies that pick them at random
+            virtual void set_fanout(int k);
+            
+            // get the ranks to send an estimate to in this exchange
+            virtual void get_destinations(std::mt19937& eng, std::vector<int>& dest) = 0;
+            
+            // get the name of the topology
+            virtual const char* name() const = 0;
+            
+            // record an estimate sent, or one adopted after the given
+            // delay since it was found and number of hops
+            void record_send(size_t num_sent = 1);
+            void record_adoption(double delay, uint32_t hops);
+            
+            // get/reset the stats
+            const topology_stats& get_stats() const;
+            void reset_stats();
+            
+        private:
+            topology_stats stats;
+            
+        };
+        
+        // k ranks picked uniformly at random, without replacement, per exchange
+        class random_topology : public topology {
+        public:
+            random_topology(int k = 5);
+            void setup(int rank, int size);
+            void set_fanout(int k);
+            void get_destinations(std::mt19937& eng, std::vector<int>& dest);
+            const char* name() const;
+            
+        private:
+            int k, num_sample;
+            std::vector<int> others;
+        };
+        
+        // the ranks directly before and after this one
+        class ring_topology : public topology {
+        public:
+            void setup(int rank, int size);
+            void get_destinations(std::mt19937& eng, std::vector<int>& dest);
+            const char* name() const;
+            
+        private:
+            std::vector<int> neighbors;
+        };
+        
+        // the four neighbors on a periodic 2D grid, with the grid
+        // shape picked by MPI_Dims_create
+        class torus2d_topology : public topology {
+        public:
+            void setup(int rank, int size);
+            void get_destinations(std::mt19937& eng, std::vector<int>& dest);
+            const char* name() const;
+            
+        private:
+            std::vector<int> neighbors;
+        };
+        
+        // the ranks differing from this one by a single bit, skipping
+        // any that do not exist when the size is not a power of two
+        class hypercube_topology : public topology {
+        public:
+            void setup(int rank, int size);
+            void get_destinations(std::mt19937& eng, std::vector<int>& dest);
+            const char* name() const;
+            
+        private:
+            std::vector<int> neighbors;
+        };
+        
+        // Watts-Strogatz style graph, where the ring lattice edges to the
+        // k nearest ranks on each side are rewired to a random rank with
+        // probability p. The rewiring is fixed by the seed
+        class small_world_topology : public topology {
+        public:
+            small_world_topology(int k = 1, double p = 0.1, unsigned seed = 0);
+            void setup(int rank, int size);
+            void get_destinations(std::mt19937& eng, std::vector<int>& dest);
+            const char* name() const;
+            
+        private:
+            int k;
+            double p;
+            unsigned seed;
+            std::vector<int> neighbors;
+        };
+        
+        // static graph read from a file, where each line holds a rank
+        // followed by the ranks it sends to. Lines starting with '#'
+        // are skipped, as are edges to ranks that do not exist. A rank
+        // that can't read the file says so on stderr and picks its
+        // destinations like random_topology instead
+        class graph_topology : public topology {
+        public:
+            graph_topology(const std::string& filename);
+            void setup(int rank, int size);
+            void set_fanout(int k);
+            void get_destinations(std::mt19937& eng, std::vector<int>& dest);
+            const char* name() const;
+            
+            // check whether the file could be read during setup
+            bool is_loaded() const;
+            
+        private:
+            std::string filename;
+            bool loaded;
+            std::vector<int> neighbors;
+            random_topology fallback;
+        };
+        
+    }
+} // end namespace async
+
+#endif /* topology_hpp */
@@ -0,0 +1,251 @@
+//
+//  bench_main.cpp
+//  async_pso
+//
+
+#include <mpi.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "async_pso/swarm.hpp"
+#include "sync_pso/sync_swarm.hpp"
+#include "bench/test_functions.hpp"
+
+/*
+ Benchmark running the asynchronous and synchronous swarms side by
+ side on a test function until they reach a target value, run out of
+ iterations or run out of time, reporting the wall time, evaluations
+ per second and iterations per second of each. Usage:
+
+    mpirun -np N ./apso_bench [--func rastrigin] [--dim 10]
+        [--particles 480] [--iters 10000] [--target 1e-4] [--time 60]
+        [--shift] [--rotate] [--sleep seconds] [--flops n]
+        [--threads 1] [--swarm both|async|sync] [--seed 17]
+        [--weak] [--format table|text|csv|json] [--trace prefix]
+
+ where the particles are the total over all ranks, split as evenly as
+ possible and at least one per rank, or the count per rank with
+ --weak, and --sleep and --flops add an artificial cost to every
+ objective evaluation. The swarm must be both, async or sync and
+ the format table (or text), csv or json. With --format csv or json
+ every swarm gets one line of output, with the per-rank timings
+ reduced over all ranks, which is what scaling_sweep.sh collects.
+ In builds with the phase profiler (make PROFILE=1 bench) the time
+ per phase of each swarm goes to stderr, and --trace writes the timeline of each swarm to the Chrome
+ trace files <prefix>.async.json and <prefix>.sync.json.
+ */
+
+struct bench_config {
+    std::string func = "rastrigin";
+    std::string swarms = "both";
+    std::string format = "table";
+    std::string trace;
+    size_t      dim = 10, particles = 480, max_iters = 10000, flops = 0;
+    double      target = 1e-4, max_time = 60.0, sleep = 0.0;
+    bool        shift = false, rotate = false, weak = false;
+    int         threads = 1;
+    uint64_t    seed = 17;
+};
+
+struct bench_result {
+    pso::stop_reason_t  reason;
+    double              wall, best;
+    size_t              evals, iters;
+    
+    // spread of the per-rank timings and evaluations
+    double              wall_min, wall_mean;
+    size_t              evals_min, evals_max;
+};
+
+// parse the command line, returning false on anything unknown
+static bool parse_args(int argc, char** argv, bench_config& cfg) {
+    for(int i = 1; i < argc; ++i){
+        const std::string arg = argv[i];
+        const bool has_val = i + 1 < argc;
+        if( arg == "--shift" ){ cfg.shift = true; }
+        else if( arg == "--rotate" ){ cfg.rotate = true; }
+        else if( arg == "--weak" ){ cfg.weak = true; }
+        else if( !has_val ){ return false; }
+        else if( arg == "--func" ){ cfg.func = argv[++i]; }
+        else if( arg == "--swarm" ){ cfg.swarms = argv[++i]; }
+        else if( arg == "--format" ){ cfg.format = argv[++i]; }
+        else if( arg == "--trace" ){ cfg.trace = argv[++i]; }
+        else if( arg == "--dim" ){ cfg.dim = std::strtoul(argv[++i], nullptr, 10); }
+        else if( arg == "--particles" ){ cfg.particles = std::strtoul(argv[++i], nullptr, 10); }
+        else if( arg == "--iters" ){ cfg.max_iters = std::strtoul(argv[++i], nullptr, 10); }
+        else if( arg == "--flops" ){ cfg.flops = std::strtoul(argv[++i], nullptr, 10); }
+        else if( arg == "--target" ){ cfg.target = std::atof(argv[++i]); }
+        else if( arg == "--time" ){ cfg.max_time = std::atof(argv[++i]); }
+        else if( arg == "--sleep" ){ cfg.sleep = std::atof(argv[++i]); }
+        else if( arg == "--threads" ){ cfg.threads = std::atoi(argv[++i]); }
+        else if( arg == "--seed" ){ cfg.seed = std::strtoull(argv[++i], nullptr, 10); }
+        else{ return false; }
+    }
+    if( cfg.format == "text" ){ cfg.format = "table"; }
+    const bool format_ok = cfg.format == "table" || cfg.format == "csv" || cfg.format == "json";
+    const bool swarms_ok = cfg.swarms == "both" || cfg.swarms == "async" || cfg.swarms == "sync";
+    return bench::make_function(cfg.func) != nullptr && cfg.dim > 0 && format_ok && swarms_ok;
+}
+
+// set up the swarm and its objective, run it, and gather the results
+template<typename swarm_t>
+static bench_result run_swarm(swarm_t& swarm_, const char* name, const bench_config& cfg, int tot_ranks) {
+    auto fn = bench::make_function(cfg.func);
+    bench::objective& obj = swarm_.get_objective_func();
+    obj.set_function(fn, cfg.dim);
+    if( cfg.shift ){ obj.set_shift(cfg.seed); }
+    if( cfg.rotate ){ obj.set_rotation(cfg.seed + 1); }
+    obj.set_cost(cfg.sleep, cfg.flops);
+
+    std::vector<double> lb(cfg.dim, fn->lower()), ub(cfg.dim, fn->upper());
+    swarm_.set_bounds(lb, ub);
+    swarm_.set_mpi_comm(MPI_COMM_WORLD);
+    swarm_.set_seed(cfg.seed);
+    swarm_.set_print_flag(false);
+    if( !cfg.trace.empty() ){ swarm_.set_tracing(cfg.trace + "." + name + ".json"); }
+    swarm_.initialize();
+
+    pso::termination_criteria criteria;
+    criteria.target_fval    = cfg.target;
+    criteria.max_iterations = cfg.max_iters;
+    criteria.max_wall_time  = cfg.max_time;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double t1 = MPI_Wtime();
+    bench_result res;
+    res.reason = swarm_.run(criteria);
+    double t2 = MPI_Wtime();
+    swarm_.finalize();
+
+    // the slowest rank sets the wall time, and the best value,
+    // evaluations and iterations are combined over all ranks
+    double wall = t2 - t1, best = swarm_.get_best_objective_value(), wall_sum = 0.0;
+    unsigned long long counts[2] = { obj.num_evals(), swarm_.get_iteration_count() }, totals[2];
+    unsigned long long evals_min = 0, evals_max = 0;
+    MPI_Allreduce(&wall, &res.wall, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(&wall, &res.wall_min, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(&wall, &wall_sum, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&best, &res.best, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(counts, totals, 2, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&counts[0], &evals_min, 1, MPI_UNSIGNED_LONG_LONG, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(&counts[0], &evals_max, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, MPI_COMM_WORLD);
+    res.wall_mean = wall_sum / tot_ranks;
+    res.evals     = totals[0];
+    res.evals_min = evals_min;
+    res.evals_max = evals_max;
+    res.iters     = totals[1] / tot_ranks;
+    return res;
+}
+
+// print the header of the results, if the format has one
+static void print_header(const bench_config& cfg) {
+    if( cfg.format == "table" ){
+        printf("%-6s %-11s %5s %6s %7s %9s %-16s %11s %11s %10s %11s %9s %11s %12s\n",
+               "swarm", "function", "dim", "ranks", "threads", "particles", "stop", "t_target_s",
+               "wall_s", "evals", "evals/s", "iters", "iters/s", "best");
+    }else if( cfg.format == "csv" ){
+        printf("swarm,function,dim,ranks,threads,particles,weak,stop,t_target_s,wall_s,"
+               "wall_min_s,wall_mean_s,evals,evals_min,evals_max,evals_per_s,iters,iters_per_s,best\n");
+    }
+}
+
+// print the results of a swarm in the chosen format
+static void print_row(const char* name, const bench_config& cfg, int tot_ranks, const bench_result& res) {
+    const int threads = std::string(name) == "async" ? cfg.threads : 1;
+    const size_t particles = cfg.weak ? cfg.particles * tot_ranks : cfg.particles;
+    const bool reached = res.reason == pso::TargetReached;
+    const double evals_rate = res.evals / res.wall, iters_rate = res.iters / res.wall;
+    if( cfg.format == "csv" ){
+        char ttt[32] = "";
+        if( reached ){ snprintf(ttt, sizeof(ttt), "%0.6e", res.wall); }
+        printf("%s,%s,%zu,%i,%i,%zu,%i,%s,%s,%0.6e,%0.6e,%0.6e,%zu,%zu,%zu,%0.6e,%zu,%0.6e,%0.8e\n",
+               name, cfg.func.c_str(), cfg.dim, tot_ranks, threads, particles, cfg.weak ? 1 : 0,
+               pso::to_string(res.reason), ttt, res.wall, res.wall_min, res.wall_mean,
+               res.evals, res.evals_min, res.evals_max, evals_rate, res.iters, iters_rate, res.best);
+    }else if( cfg.format == "json" ){
+        char ttt[32] = "null";
+        if( reached ){ snprintf(ttt, sizeof(ttt), "%0.6e", res.wall); }
+        printf("{\"swarm\": \"%s\", \"function\": \"%s\", \"dim\": %zu, \"ranks\": %i, \"threads\": %i, "
+               "\"particles\": %zu, \"weak\": %s, \"stop\": \"%s\", \"t_target_s\": %s, \"wall_s\": %0.6e, "
+               "\"wall_min_s\": %0.6e, \"wall_mean_s\": %0.6e, \"evals\": %zu, \"evals_min\": %zu, "
+               "\"evals_max\": %zu, \"evals_per_s\": %0.6e, \"iters\": %zu, \"iters_per_s\": %0.6e, \"best\": %0.8e}\n",
+               name, cfg.func.c_str(), cfg.dim, tot_ranks, threads, particles, cfg.weak ? "true" : "false",
+               pso::to_string(res.reason), ttt, res.wall, res.wall_min, res.wall_mean,
+               res.evals, res.evals_min, res.evals_max, evals_rate, res.iters, iters_rate, res.best);
+    }else{
+        char ttt[32] = "-";
+        if( reached ){ snprintf(ttt, sizeof(ttt), "%0.4e", res.wall); }
+        printf("%-6s %-11s %5zu %6i %7i %9zu %-16s %11s %11.4e %10zu %11.4e %9zu %11.4e %12.5e\n",
+               name, cfg.func.c_str(), cfg.dim, tot_ranks, threads, particles, pso::to_string(res.reason),
+               ttt, res.wall, res.evals, evals_rate, res.iters, iters_rate, res.best);
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+
+    // initialize the MPI stuff
+    int thread_support;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &thread_support);
+
+    int local_rank, tot_ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &local_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &tot_ranks);
+
+    // get the settings
+    bench_config cfg;
+    if( !parse_args(argc, argv, cfg) ){
+        if( local_rank == 0 ){
+            printf("Usage: apso_bench [--func name] [--dim d] [--particles n] [--iters n] [--target f]\n"
+                   "                  [--time s] [--shift] [--rotate] [--sleep s] [--flops n]\n"
+                   "                  [--threads k] [--swarm both|async|sync] [--seed s]\n"
+                   "                  [--weak] [--format table|text|csv|json] [--trace prefix]\n"
+                   "Functions:");
+            for(auto& name: bench::function_names()){ printf(" %s", name.c_str()); }
+            printf("\n");
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    
+    // every rank needs at least one particle
+    const size_t min_particles = cfg.weak ? 1 : static_cast<size_t>(tot_ranks);
+    if( cfg.particles < min_particles ){
+        if( local_rank == 0 ){
+            printf("apso_bench: --particles %zu gives ranks no particles, it needs to be at least %zu%s\n",
+                   cfg.particles, min_particles, cfg.weak ? "" : " (the number of ranks)");
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    
+    // split the total evenly, with the first ranks taking one more
+    // each when it doesn't divide, so no particles are dropped
+    size_t share = cfg.particles;
+    if( !cfg.weak ){
+        share = cfg.particles / tot_ranks + (static_cast<size_t>(local_rank) < cfg.particles % tot_ranks ? 1 : 0);
+    }
+    const int num_particles = static_cast<int>(share);
+    if( local_rank == 0 ){ print_header(cfg); }
+
+    // run the swarms one after the other
+    if( cfg.swarms == "both" || cfg.swarms == "async" ){
+        async::pso::swarm<bench::objective> swarm_( num_particles );
+        swarm_.set_num_threads(cfg.threads);
+        bench_result res = run_swarm(swarm_, "async", cfg, tot_ranks);
+        if( local_rank == 0 ){ print_row("async", cfg, tot_ranks, res); }
+        swarm_.get_profiler().report(MPI_COMM_WORLD, stderr, "the async swarm");
+    }
+    if( cfg.swarms == "both" || cfg.swarms == "sync" ){
+        sync::pso::swarm<bench::objective> swarm_( num_particles );
+        bench_result res = run_swarm(swarm_, "sync", cfg, tot_ranks);
+        if( local_rank == 0 ){ print_row("sync", cfg, tot_ranks, res); }
+        swarm_.get_profiler().report(MPI_COMM_WORLD, stderr, "the sync swarm");
+    }
+
+    // finalize
+    MPI_Finalize();
+    return 0;
+}
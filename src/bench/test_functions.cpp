@@ -0,0 +1,201 @@
+//
+//  test_functions.cpp
+//  async_pso
+//
+
+#include "test_functions.hpp"
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+
+namespace bench {
+
+    static const double pi = 3.14159265358979323846;
+
+    double sphere::operator()(const double* x, size_t dim) const {
+        double val = 0.0;
+        for(size_t i = 0; i < dim; ++i){ val += x[i]*x[i]; }
+        return val;
+    }
+
+    double rastrigin::operator()(const double* x, size_t dim) const {
+        double val = 10.0*dim;
+        for(size_t i = 0; i < dim; ++i){
+            val += x[i]*x[i] - 10.0*std::cos(2.0*pi*x[i]);
+        }
+        return val;
+    }
+
+    double rosenbrock::operator()(const double* x, size_t dim) const {
+        double val = 0.0;
+        for(size_t i = 0; i + 1 < dim; ++i){
+            const double a = x[i+1] - x[i]*x[i];
+            const double b = 1.0 - x[i];
+            val += 100.0*a*a + b*b;
+        }
+        return val;
+    }
+
+    double ackley::operator()(const double* x, size_t dim) const {
+        if( dim == 0 ){ return 0.0; }
+        double s2 = 0.0, sc = 0.0;
+        for(size_t i = 0; i < dim; ++i){
+            s2 += x[i]*x[i];
+            sc += std::cos(2.0*pi*x[i]);
+        }
+        return -20.0*std::exp(-0.2*std::sqrt(s2/dim)) - std::exp(sc/dim) + 20.0 + std::exp(1.0);
+    }
+
+    double griewank::operator()(const double* x, size_t dim) const {
+        double s = 0.0, p = 1.0;
+        for(size_t i = 0; i < dim; ++i){
+            s += x[i]*x[i];
+            p *= std::cos(x[i] / std::sqrt(i + 1.0));
+        }
+        return s/4000.0 - p + 1.0;
+    }
+
+    // outside of [-500, 500] the function is folded back into the domain
+    // with a quadratic penalty, as in the CEC 2014 suite, so shifted and
+    // rotated problems can't find anything below 0 past the boundary
+    double schwefel::operator()(const double* x, size_t dim) const {
+        double val = 418.9828872724338*dim;
+        for(size_t i = 0; i < dim; ++i){
+            const double z = x[i];
+            if( std::abs(z) <= 500.0 ){
+                val -= z*std::sin(std::sqrt(std::abs(z)));
+            }else{
+                const double r = std::copysign(500.0 - std::fmod(std::abs(z), 500.0), z);
+                const double d = std::abs(z) - 500.0;
+                val -= r*std::sin(std::sqrt(std::abs(r))) - d*d/(10000.0*dim);
+            }
+        }
+        return val;
+    }
+
+    // get a test function by name
+    std::shared_ptr<const test_function> make_function(const std::string& name) {
+        if( name == "sphere" ){ return std::make_shared<sphere>(); }
+        if( name == "rastrigin" ){ return std::make_shared<rastrigin>(); }
+        if( name == "rosenbrock" ){ return std::make_shared<rosenbrock>(); }
+        if( name == "ackley" ){ return std::make_shared<ackley>(); }
+        if( name == "griewank" ){ return std::make_shared<griewank>(); }
+        if( name == "schwefel" ){ return std::make_shared<schwefel>(); }
+        return nullptr;
+    }
+    std::vector<std::string> function_names() {
+        return {"sphere", "rastrigin", "rosenbrock", "ackley", "griewank", "schwefel"};
+    }
+
+    // ctor/dtor
+    objective::objective():fn(std::make_shared<sphere>()), dim(0), sleep_seconds(0.0), flops(0),
+    nevals(std::make_shared<std::atomic<size_t>>(0))
+    {}
+
+    // set the test function for some dimension
+    void objective::set_function(std::shared_ptr<const test_function> fn_, size_t dim_) {
+        fn  = fn_;
+        dim = dim_;
+        shift.clear();
+        rot.clear();
+    }
+    const test_function& objective::get_function() const {
+        return *fn;
+    }
+    size_t objective::num_dims() const {
+        return dim;
+    }
+
+    // move the optimum to a random point in the middle half of the domain
+    void objective::set_shift(uint64_t seed) {
+        std::mt19937_64 eng(seed);
+        const double mid = 0.5*(fn->lower() + fn->upper());
+        const double half = 0.25*(fn->upper() - fn->lower());
+        std::uniform_real_distribution<double> U(mid - half, mid + half);
+        shift.resize(dim);
+        for(auto& o: shift){ o = U(eng); }
+    }
+    const std::vector<double>& objective::get_shift() const {
+        return shift;
+    }
+
+    // apply a random rotation, from Gram-Schmidt on a Gaussian matrix
+    void objective::set_rotation(uint64_t seed) {
+        std::mt19937_64 eng(seed);
+        std::normal_distribution<double> N(0.0, 1.0);
+        rot.resize(dim*dim);
+        for(auto& r: rot){ r = N(eng); }
+        for(size_t i = 0; i < dim; ++i){
+            double* ri = &rot[i*dim];
+            for(size_t j = 0; j < i; ++j){
+                const double* rj = &rot[j*dim];
+                double d = 0.0;
+                for(size_t k = 0; k < dim; ++k){ d += ri[k]*rj[k]; }
+                for(size_t k = 0; k < dim; ++k){ ri[k] -= d*rj[k]; }
+            }
+            double n = 0.0;
+            for(size_t k = 0; k < dim; ++k){ n += ri[k]*ri[k]; }
+            n = std::sqrt(n);
+            for(size_t k = 0; k < dim; ++k){ ri[k] /= n; }
+        }
+    }
+
+    // make every call cost a sleep plus some number of multiply-adds
+    void objective::set_cost(double sleep_seconds_, size_t flops_) {
+        sleep_seconds = sleep_seconds_;
+        flops = flops_;
+    }
+
+    // evaluate the objective
+    double objective::operator()(const std::vector<double>& x) const {
+        ++(*nevals);
+        spend();
+
+        // map x into the frame of the test function
+        thread_local std::vector<double> y, z;
+        const size_t n = x.size();
+        y.resize(n);
+        z.resize(n);
+        for(size_t i = 0; i < n; ++i){
+            y[i] = shift.size() == n ? x[i] - shift[i] : x[i];
+        }
+        if( rot.size() == n*n ){
+            for(size_t i = 0; i < n; ++i){
+                double v = 0.0;
+                for(size_t k = 0; k < n; ++k){ v += rot[i*n+k]*y[k]; }
+                z[i] = v;
+            }
+        }else{
+            z = y;
+        }
+
+        // plain problems keep the optimum of the function where it is
+        if( !shift.empty() || !rot.empty() ){
+            for(auto& zi: z){ zi += fn->optimum_coord(); }
+        }
+        return (*fn)(z.data(), n);
+    }
+
+    // get/reset the number of calls made on this rank
+    size_t objective::num_evals() const {
+        return *nevals;
+    }
+    void objective::reset_evals() {
+        *nevals = 0;
+    }
+
+    // burn the extra cost of a call
+    void objective::spend() const {
+        if( sleep_seconds > 0.0 ){
+            std::this_thread::sleep_for(std::chrono::duration<double>(sleep_seconds));
+        }
+        if( flops ){
+            double a = 1.0000001, b = 0.9999999;
+            for(size_t k = 0; k < flops; ++k){ a = a*b + 1e-12; }
+            volatile double sink = a;
+            (void)sink;
+        }
+    }
+
+}// end namespace bench
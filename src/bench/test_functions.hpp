@@ -0,0 +1,154 @@
+//
+//  test_functions.hpp
+//  async_pso
+//
+
+#ifndef test_functions_hpp
+#define test_functions_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+    /*
+     Scalable test function with a global minimum of 0. The
+     minimum is at the point with every coordinate equal to
+     optimum_coord(), and the usual search domain is the
+     hypercube [lower(), upper()]^dim.
+     */
+    class test_function {
+    public:
+        virtual ~test_function() = default;
+        virtual double operator()(const double* x, size_t dim) const = 0;
+        virtual const char* name() const = 0;
+        virtual double lower() const = 0;
+        virtual double upper() const = 0;
+        virtual double optimum_coord() const { return 0.0; }
+    };
+
+    // sum of squares
+    class sphere : public test_function {
+    public:
+        double operator()(const double* x, size_t dim) const;
+        const char* name() const { return "sphere"; }
+        double lower() const { return -5.12; }
+        double upper() const { return 5.12; }
+    };
+
+    // highly multimodal, with a regular grid of local minima
+    class rastrigin : public test_function {
+    public:
+        double operator()(const double* x, size_t dim) const;
+        const char* name() const { return "rastrigin"; }
+        double lower() const { return -5.12; }
+        double upper() const { return 5.12; }
+    };
+
+    // narrow curved valley
+    class rosenbrock : public test_function {
+    public:
+        double operator()(const double* x, size_t dim) const;
+        const char* name() const { return "rosenbrock"; }
+        double lower() const { return -5.0; }
+        double upper() const { return 10.0; }
+        double optimum_coord() const { return 1.0; }
+    };
+
+    // nearly flat outer region with a deep hole at the center
+    class ackley : public test_function {
+    public:
+        double operator()(const double* x, size_t dim) const;
+        const char* name() const { return "ackley"; }
+        double lower() const { return -32.768; }
+        double upper() const { return 32.768; }
+    };
+
+    // many widespread, regularly distributed local minima
+    class griewank : public test_function {
+    public:
+        double operator()(const double* x, size_t dim) const;
+        const char* name() const { return "griewank"; }
+        double lower() const { return -600.0; }
+        double upper() const { return 600.0; }
+    };
+
+    // deceptive, with the best local minima far from the global one
+    class schwefel : public test_function {
+    public:
+        double operator()(const double* x, size_t dim) const;
+        const char* name() const { return "schwefel"; }
+        double lower() const { return -500.0; }
+        double upper() const { return 500.0; }
+        double optimum_coord() const { return 420.968746; }
+    };
+
+    // get a test function by name, or a null pointer if unknown
+    std::shared_ptr<const test_function> make_function(const std::string& name);
+
+    // get the names of all the test functions
+    std::vector<std::string> function_names();
+
+    /*
+     Objective for the swarms built on a test function. It evaluates
+
+        f(x) = g( R (x - o) + c )
+
+     where g is the test function, o a shift of the optimum, R an
+     orthogonal rotation and c the optimum of g, so the minimum of
+     0 sits at x = o. A problem with neither a shift nor a rotation
+     is just g(x). It can also be made artificially expensive
+     with a sleep and some extra floating point work per call.
+     Copies share the evaluation counter, and calls are thread safe.
+     */
+    class objective {
+    public:
+
+        // ctor/dtor
+        objective();
+        ~objective() = default;
+
+        // set the test function for some dimension, which
+        // clears any shift and rotation
+        void set_function(std::shared_ptr<const test_function> fn, size_t dim);
+        const test_function& get_function() const;
+        size_t num_dims() const;
+
+        // move the optimum to a random point in the middle half of
+        // the domain and/or apply a random rotation
+        void set_shift(uint64_t seed);
+        void set_rotation(uint64_t seed);
+        const std::vector<double>& get_shift() const;
+
+        // make every call cost a sleep plus some number of
+        // multiply-adds that can't be optimized away
+        void set_cost(double sleep_seconds, size_t flops);
+
+        // evaluate the objective
+        double operator()(const std::vector<double>& x) const;
+
+        // get/reset the number of calls made on this rank
+        size_t num_evals() const;
+        void reset_evals();
+
+    private:
+
+        std::shared_ptr<const test_function>    fn;
+        size_t                                  dim;
+        std::vector<double>                     shift, rot;
+        double                                  sleep_seconds;
+        size_t                                  flops;
+        std::shared_ptr<std::atomic<size_t>>    nevals;
+
+        // burn the extra cost of a call
+        void spend() const;
+
+    };
+
+}// end namespace bench
+
+#endif /* test_functions_hpp */
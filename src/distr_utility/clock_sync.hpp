@@ -0,0 +1,61 @@
+//
+//  clock_sync.hpp
+//  async_pso
+//
+
+#ifndef clock_sync_hpp
+#define clock_sync_hpp
+
+#include <mpi.h>
+#include <limits>
+
+namespace distributed {
+
+    /*
+     Get the offset that maps times of the clock now() on this rank
+     to the clock of rank 0 of the communicator, so now() + offset
+     can be compared across ranks. Rank 0 answers num_rounds pings
+     of every other rank with its time, and each rank keeps the
+     offset of the round trip that took the least time, taking the
+     reply to be stamped halfway through it. Collective, and the
+     communicator should be a private one so nothing else in flight
+     can match these messages.
+     */
+    template<typename Clock>
+    auto clock_offset(MPI_Comm comm, Clock now, int num_rounds = 16) -> decltype(now()) {
+        using time_t_ = decltype(now());
+        int rank = 0, size = 1;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &size);
+
+        time_t_ offset = 0;
+        if( rank == 0 ){
+            for(int r = 1; r < size; ++r){
+                for(int k = 0; k < num_rounds; ++k){
+                    int ping = 0;
+                    MPI_Recv(&ping, 1, MPI_INT, r, 0, comm, MPI_STATUS_IGNORE);
+                    const time_t_ t = now();
+                    MPI_Send(&t, sizeof(t), MPI_BYTE, r, 0, comm);
+                }
+            }
+        }else{
+            time_t_ best_rtt = std::numeric_limits<time_t_>::max();
+            for(int k = 0; k < num_rounds; ++k){
+                int ping = 0;
+                time_t_ t_remote = 0;
+                const time_t_ t0 = now();
+                MPI_Send(&ping, 1, MPI_INT, 0, 0, comm);
+                MPI_Recv(&t_remote, sizeof(t_remote), MPI_BYTE, 0, 0, comm, MPI_STATUS_IGNORE);
+                const time_t_ t1 = now();
+                if( t1 - t0 < best_rtt ){
+                    best_rtt = t1 - t0;
+                    offset = t_remote - (t0 + (t1 - t0)/2);
+                }
+            }
+        }
+        return offset;
+    }
+
+}// end namespace distributed
+
+#endif /* clock_sync_hpp */
@@ -0,0 +1,140 @@
+//
+//  comm_stats.cpp
+//  async_pso
+//
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "comm_stats.hpp"
+
+namespace distributed {
+
+    constexpr int       latency_histogram::sub_bits;
+    constexpr uint64_t  latency_histogram::sub_count;
+    constexpr uint64_t  latency_histogram::half_count;
+    constexpr size_t    latency_histogram::num_buckets;
+
+    // ctor/dtor
+    latency_histogram::latency_histogram():counts(num_buckets, 0) {
+        clear();
+    }
+
+    // record a latency in seconds
+    void latency_histogram::record(double seconds) {
+        const double ns_ = seconds > 0.0 ? seconds*1e9 : 0.0;
+        const uint64_t ns = ns_ < 1.8e19 ? static_cast<uint64_t>(ns_) : std::numeric_limits<uint64_t>::max();
+        ++counts[bucket_of(ns)];
+        ++total;
+        min_ns = std::min(min_ns, ns);
+        max_ns = std::max(max_ns, ns);
+        sum_ns += static_cast<double>(ns);
+    }
+
+    // add in the values of another histogram
+    void latency_histogram::merge(const latency_histogram& other) {
+        for(size_t i = 0; i < num_buckets; ++i){ counts[i] += other.counts[i]; }
+        total  += other.total;
+        min_ns  = std::min(min_ns, other.min_ns);
+        max_ns  = std::max(max_ns, other.max_ns);
+        sum_ns += other.sum_ns;
+    }
+
+    // forget all the values
+    void latency_histogram::clear() {
+        std::fill(counts.begin(), counts.end(), 0);
+        total  = 0;
+        min_ns = std::numeric_limits<uint64_t>::max();
+        max_ns = 0;
+        sum_ns = 0.0;
+    }
+
+    // get stats on the values
+    uint64_t latency_histogram::count() const {
+        return total;
+    }
+    double latency_histogram::min() const {
+        return total ? 1e-9*min_ns : 0.0;
+    }
+    double latency_histogram::max() const {
+        return 1e-9*max_ns;
+    }
+    double latency_histogram::mean() const {
+        return total ? 1e-9*sum_ns/total : 0.0;
+    }
+    double latency_histogram::percentile(double pct) const {
+        if( total == 0 ){ return 0.0; }
+
+        // find the bucket holding the value of that rank
+        const double frac = std::min(std::max(pct, 0.0), 100.0) / 100.0;
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(frac*total)));
+        uint64_t seen = 0;
+        size_t idx = 0;
+        for(; idx + 1 < num_buckets; ++idx){
+            seen += counts[idx];
+            if( seen >= rank ){ break; }
+        }
+
+        // the middle of the bucket, kept within the values seen
+        const double mid = static_cast<double>(bucket_low(idx)) + 0.5*static_cast<double>(bucket_width(idx) - 1);
+        return 1e-9*std::min(std::max(mid, static_cast<double>(min_ns)), static_cast<double>(max_ns));
+    }
+
+    // values below sub_count get a bucket each, and the values in
+    // [2^m, 2^(m+1)) for m >= sub_bits share half_count buckets
+    size_t latency_histogram::bucket_of(uint64_t ns) {
+        if( ns < sub_count ){ return static_cast<size_t>(ns); }
+        int msb = 63;
+        while( !(ns >> msb) ){ --msb; }
+        const int shift = msb - (sub_bits - 1);
+        const uint64_t sub = ns >> shift;
+        return static_cast<size_t>(sub_count + (shift - 1)*half_count + (sub - half_count));
+    }
+    uint64_t latency_histogram::bucket_low(size_t idx) {
+        if( idx < sub_count ){ return idx; }
+        const uint64_t shift = (idx - sub_count)/half_count + 1;
+        const uint64_t sub = (idx - sub_count)%half_count + half_count;
+        return sub << shift;
+    }
+    uint64_t latency_histogram::bucket_width(size_t idx) {
+        if( idx < sub_count ){ return 1; }
+        return uint64_t(1) << ((idx - sub_count)/half_count + 1);
+    }
+
+    // ctor
+    msg_type_stats::msg_type_stats():sent(0), bytes_sent(0), received(0), bytes_received(0)
+    {}
+
+    // ctor
+    comm_stats::comm_stats() {
+        clear();
+    }
+
+    // reset all the counters
+    void comm_stats::clear() {
+        types.clear();
+        probes = empty_probes = probe_cap_hits = unmatched_responses = 0;
+        max_pending_sends = max_pending_receives = max_outstanding = 0;
+    }
+
+    // print the counters and latency percentiles
+    void comm_stats::print(FILE* out, const char* name) const {
+        fprintf(out, "%s: probes %llu (empty %llu, cap hits %llu), unmatched responses %llu\n", name,
+                static_cast<unsigned long long>(probes), static_cast<unsigned long long>(empty_probes),
+                static_cast<unsigned long long>(probe_cap_hits), static_cast<unsigned long long>(unmatched_responses));
+        fprintf(out, "  max pending sends %zu, max pending receives %zu, max outstanding requests %zu\n",
+                max_pending_sends, max_pending_receives, max_outstanding);
+        fprintf(out, "  %4s %10s %12s %10s %12s %9s %10s %10s %10s %10s %10s\n", "type", "sent", "bytes_sent",
+                "received", "bytes_recv", "rtt_count", "rtt_min_s", "rtt_p50_s", "rtt_p90_s", "rtt_p99_s", "rtt_max_s");
+        for(const auto& entry: types){
+            const msg_type_stats& s = entry.second;
+            const latency_histogram& h = s.round_trip;
+            fprintf(out, "  %4i %10llu %12llu %10llu %12llu %9llu %10.3e %10.3e %10.3e %10.3e %10.3e\n", entry.first,
+                    static_cast<unsigned long long>(s.sent), static_cast<unsigned long long>(s.bytes_sent),
+                    static_cast<unsigned long long>(s.received), static_cast<unsigned long long>(s.bytes_received),
+                    static_cast<unsigned long long>(h.count()), h.min(), h.percentile(50.0), h.percentile(90.0),
+                    h.percentile(99.0), h.max());
+        }
+    }
+
+}
@@ -0,0 +1,111 @@
+//
+//  comm_stats.hpp
+//  async_pso
+//
+
+#ifndef comm_stats_hpp
+#define comm_stats_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+namespace distributed {
+
+    /*
+     Histogram of latencies in the style of HdrHistogram, with
+     values kept in nanoseconds in log-linear buckets. Below 32ns
+     every value gets its own bucket, and every power of two above
+     is split into 16 linear buckets, so any value is known to
+     within 1/16 (6.25%) of itself, from nanoseconds up to years,
+     in a fixed 976 counters.
+     */
+    class latency_histogram {
+    public:
+
+        // ctor/dtor
+        latency_histogram();
+        ~latency_histogram() = default;
+
+        // record a latency in seconds
+        void record(double seconds);
+
+        // add in the values of another histogram
+        void merge(const latency_histogram& other);
+
+        // forget all the values
+        void clear();
+
+        // get stats on the values, in seconds, where the percentile
+        // (0 to 100) is the middle of the bucket it falls into
+        uint64_t count() const;
+        double min() const;
+        double max() const;
+        double mean() const;
+        double percentile(double pct) const;
+
+    private:
+
+        static constexpr int        sub_bits    = 5;
+        static constexpr uint64_t   sub_count   = uint64_t(1) << sub_bits;
+        static constexpr uint64_t   half_count  = sub_count / 2;
+        static constexpr size_t     num_buckets = sub_count + (64 - sub_bits)*half_count;
+
+        std::vector<uint64_t>   counts;
+        uint64_t                total, min_ns, max_ns;
+        double                  sum_ns;
+
+        // map values to buckets and buckets to their value range
+        static size_t bucket_of(uint64_t ns);
+        static uint64_t bucket_low(size_t idx);
+        static uint64_t bucket_width(size_t idx);
+
+    };
+
+    // counters of the messages of one type
+    struct msg_type_stats {
+        uint64_t            sent, bytes_sent;
+        uint64_t            received, bytes_received;
+        latency_histogram   round_trip;     // from a send to its response
+
+        msg_type_stats();
+    };
+
+    /*
+     Counters of the traffic through a message manager. Messages
+     are counted by the type in their metadata, so requests and
+     their responses show up under their own types, while the
+     round trip latency of a request is kept under the request type.
+     */
+    struct comm_stats {
+
+        // counters per message type
+        std::map<int, msg_type_stats> types;
+
+        // probes done, the ones that found nothing, and the calls that
+        // matched as many messages as they were allowed to, meaning more
+        // may have been waiting
+        uint64_t probes, empty_probes, probe_cap_hits;
+
+        // responses that matched no outstanding message and were dropped
+        uint64_t unmatched_responses;
+
+        // most sends waiting to complete, receives in flight and
+        // requests waiting on a response seen at once
+        size_t max_pending_sends, max_pending_receives, max_outstanding;
+
+        // ctor
+        comm_stats();
+
+        // reset all the counters
+        void clear();
+
+        // print the counters and latency percentiles
+        void print(FILE* out, const char* name) const;
+    };
+
+}
+
+#endif /* comm_stats_hpp */
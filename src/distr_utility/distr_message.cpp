@@ -12,10 +12,17 @@ namespace distributed {
     
     // ctor/dtor
     message::message() {
+        reset();
+    }
+    
+    // reset the message state so it can be reused
+    void message::reset() {
         task_id = ID = tag = my_rank = dest_rank = -1;
         error_code = message_type = send_data_size = response_size = 0;
-        did_get_response_ = false;
+        response_offset = 0;
+        did_get_response_ = is_sync = false;
         comm = MPI_COMM_WORLD;
+        req = MPI_REQUEST_NULL;
     }
         
         // method to send the message
@@ -26,13 +33,23 @@ namespace distributed {
         int buf_size= static_cast<int>(get_send_buffer_size());
         
         // send the non-blocking message
-        error_code = MPI_Isend(buf,
-                               buf_size,
-                               MPI_BYTE,
-                               dest_rank,
-                               tag,
-                               comm,
-                               &req);
+        if( is_sync ){
+            error_code = MPI_Issend(buf,
+                                    buf_size,
+                                    MPI_BYTE,
+                                    dest_rank,
+                                    tag,
+                                    comm,
+                                    &req);
+        }else{
+            error_code = MPI_Isend(buf,
+                                   buf_size,
+                                   MPI_BYTE,
+                                   dest_rank,
+                                   tag,
+                                   comm,
+                                   &req);
+        }
         
         // return the error code
         return error_code;
@@ -63,6 +80,10 @@ namespace distributed {
         tag = tag_;
         return *this;
     }
+    message& message::set_synchronous(bool is_sync_) {
+        is_sync = is_sync_;
+        return *this;
+    }
     
     int message::get_type() const {
         return message_type;
@@ -86,20 +107,31 @@ namespace distributed {
     size_t message::get_send_buffer_size() const {
         return send_data_size;
     }
+    byte_t* message::reserve_send_buffer(size_t nbytes) {
+        if( send_data.size() < nbytes ){ send_data.resize(nbytes); }
+        send_data_size = nbytes;
+        return &send_data[0];
+    }
     
     // incoming buffer stuff
     const byte_t* message::get_receive_buffer() const {
-        return &response_data[0];
+        return &response_data[response_offset];
     }
     byte_t* message::get_receive_buffer() {
-        return &response_data[0];
+        return &response_data[response_offset];
     }
     size_t message::get_receive_buffer_size() const {
         return response_size;
     }
     void message::resize_receive_buffer(size_t nsize) {
         response_data.resize(nsize);
-        response_size = nsize;
+        response_size   = nsize;
+        response_offset = 0;
+    }
+    void message::swap_receive_buffer(std::vector<byte_t>& buf, size_t offset) {
+        response_data.swap(buf);
+        response_size   = response_data.size() - offset;
+        response_offset = offset;
     }
     
     // method to fill up buffers
@@ -107,7 +139,8 @@ namespace distributed {
         if( buf_type == Send ){
             send_data_size = 0;
         }else{
-            response_size = 0;
+            response_size   = 0;
+            response_offset = 0;
         }
     }
     
@@ -39,6 +39,10 @@ namespace distributed {
         message& set_msg_type(int mtype);
         message& set_msg_tag(int tag);
         
+        // use a synchronous send, which only completes once
+        // the destination has started receiving the message
+        message& set_synchronous(bool is_sync);
+        
         // getter methods
         int get_type() const;
         int get_dest_rank() const;
@@ -56,15 +60,27 @@ namespace distributed {
         byte_t* get_send_buffer();
         size_t get_send_buffer_size() const;
         
+        // size the outgoing buffer to nbytes in one go and return it
+        // to be written directly, instead of growing it per add_data
+        byte_t* reserve_send_buffer(size_t nbytes);
+        
         // incoming buffer stuff
         const byte_t* get_receive_buffer() const;
         void resize_receive_buffer(size_t nsize);
         byte_t* get_receive_buffer();
         size_t get_receive_buffer_size() const;
         
+        // take over a received buffer whose payload starts at offset,
+        // handing the old receive buffer back through buf
+        void swap_receive_buffer(std::vector<byte_t>& buf, size_t offset);
+        
         // method to fill up buffers
         void reset_buffer(int buf_type = Send);
         
+        // reset the message state so it can be reused,
+        // keeping the capacity of both buffers
+        void reset();
+        
         template<typename T> void add_data(const T& out_data, int buf_type = Send) {
             std::vector<byte_t>* bufs[2] = { &send_data, &response_data };
             size_t* buf_sizes[2] = { &send_data_size, &response_size };
@@ -91,9 +107,9 @@ namespace distributed {
         std::vector<byte_t> send_data;
         size_t              send_data_size;
         std::vector<byte_t> response_data;
-        size_t              response_size;
+        size_t              response_size, response_offset;
         MPI_Request         req;
-        bool                did_get_response_;
+        bool                did_get_response_, is_sync;
         MPI_Comm            comm;
     };
 }
@@ -6,12 +6,23 @@
 //  Copyright © 2019 Christian Howard. All rights reserved.
 //
 
+#include <algorithm>
+#include <cstdint>
 #include "message_manager2.hpp"
 
 
 namespace distributed {
     
-    msg_manager2::msg_manager2():num_complete(0),tag(101),manager_id(0){
+    // layout of the metadata when sent over the wire
+    struct metadata_wire_t {
+        uint8_t     is_response;
+        uint8_t     reserved[3];
+        int32_t     msg_type;
+        uint32_t    mngr_id, msg_id;
+    };
+    static_assert(sizeof(metadata_wire_t) == 16, "wire metadata must not be padded");
+    
+    msg_manager2::msg_manager2():num_complete(0),tag(101),manager_id(0),tracer(nullptr),trace_cat("msg"){
         comm = MPI_COMM_WORLD;
         MPI_Comm_rank(comm, &local_rank);
     }
@@ -38,8 +49,9 @@ namespace distributed {
     size_t msg_manager2::create_message() {
         size_t size_ = messages.size();
         messages.emplace_back();
-        messages[size_].free();
-        messages[size_].create();
+        acquire_message(messages[size_]);
+        send_times.push_back(0.0);
+        stats.max_outstanding = std::max(stats.max_outstanding, messages.size());
         
         // initialize the message with the known details
         util::raw_handle<message> msg_ = messages[size_];
@@ -54,7 +66,7 @@ namespace distributed {
     typename msg_manager2::uniq_msg_t msg_manager2::create_indep_message() {
         
         uniq_msg_t msg_;
-        msg_.create();
+        acquire_message(msg_);
         msg_->set_communicator(comm)
         .set_msg_tag(tag)
         .set_message_id(0)
@@ -65,6 +77,35 @@ namespace distributed {
     
     void msg_manager2::add_msg_to_response_queue(uniq_msg_t msg) {
         response_q.push(msg);
+        stats.max_pending_sends = std::max(stats.max_pending_sends, response_q.size());
+    }
+    
+    // send a message made by create_message
+    void msg_manager2::send_message(size_t message_id) {
+        message& msg_ = *messages[message_id];
+        record_send(msg_);
+        send_times[message_id] = MPI_Wtime();
+        msg_.send();
+    }
+    
+    // send an independent message and queue it up
+    void msg_manager2::send_indep_message(uniq_msg_t msg) {
+        record_send(*msg);
+        msg->send();
+        add_msg_to_response_queue(msg);
+    }
+    
+    // count a message sent out, under the type in its metadata
+    void msg_manager2::record_send(const message& msg) {
+        metadata_t metadata;
+        deserialize_metadata(metadata, msg.get_send_buffer());
+        msg_type_stats& s = stats.types[metadata.msg_type];
+        ++s.sent;
+        s.bytes_sent += msg.get_send_buffer_size();
+        if( tracer ){
+            tracer->instant(metadata.is_response ? "send response" : "send", trace_cat, msg.get_dest_rank(),
+                            metadata.msg_type, static_cast<int64_t>(msg.get_send_buffer_size()));
+        }
     }
     
     size_t msg_manager2::num_messages() const {
@@ -75,9 +116,10 @@ namespace distributed {
     }
     void msg_manager2::clear_messages() {
         for(size_t i = 0; i < messages.size(); ++i){
-            messages[i].free();
+            release_message(messages[i]);
         }
         messages.resize(0);
+        send_times.resize(0);
         num_complete = 0;
     }
     
@@ -95,12 +137,14 @@ namespace distributed {
             // if test shows the request is not complete,
             // then push the msg back onto the queue
             if( !flag ){ response_q.push(msg); }
-            else{ msg.free(); }
+            else{ release_message(msg); }
         }// end loop over your response queue
     }
     void msg_manager2::probe_for_responses(int num2process) {
+        int nmatched = 0;
         for(int i = 0; i < num2process; ++i){
             auto probe_ = perform_nonblock_probe();
+            ++stats.probes;
             
             if( probe_.flag && probe_.error_code == MPI_SUCCESS ){
                 
@@ -112,28 +156,33 @@ namespace distributed {
                               MPI_BYTE,
                               &incoming_data_size);
                 
-                // create an async recv instance
+                // create an async recv instance, where the buffer
+                // keeps whatever capacity it had from earlier use
                 uniq_arecv_t arecv_;
-                arecv_.create();
+                arecv_.adopt(recv_pool.acquire());
                 arecv_->buf.resize(incoming_data_size);
                 arecv_->src_rank = probe_.status.MPI_SOURCE;
                 
-                // do a non-blocking receive
-                int err = MPI_Irecv(arecv_->buf.data(),
-                                    incoming_data_size,
-                                    MPI_BYTE,
-                                    probe_.status.MPI_SOURCE,
-                                    tag,
-                                    comm,
-                                    &arecv_->req);
+                // do a non-blocking receive of the matched message,
+                // so no other receive can steal it in the meantime
+                int err = MPI_Imrecv(arecv_->buf.data(),
+                                     incoming_data_size,
+                                     MPI_BYTE,
+                                     &probe_.handle,
+                                     &arecv_->req);
                 
                 // add this async recv to the queue
                 recv_q.push(arecv_);
+                ++nmatched;
                 
             }else{
-                if( !probe_.flag ){ break; }
+                if( !probe_.flag ){ ++stats.empty_probes; break; }
             }
         }// end for i
+        
+        // a call that used up its whole budget may have left messages behind
+        if( num2process > 0 && nmatched == num2process ){ ++stats.probe_cap_hits; }
+        stats.max_pending_receives = std::max(stats.max_pending_receives, recv_q.size());
     }
     void msg_manager2::check_get_async_responses() {
         size_t size_ = recv_q.size();
@@ -143,7 +192,7 @@ namespace distributed {
             MPI_Test(&arecv->req, &flag, MPI_STATUS_IGNORE);
             if( flag ){
                 process_recv(*arecv);
-                arecv.free();
+                recv_pool.release(arecv.release());
             }else{ recv_q.push(arecv); }
         }
     }
@@ -151,25 +200,46 @@ namespace distributed {
     void msg_manager2::process_recv(async_recv& arecv) {
         
         // now parse the message for important data
+        const uint64_t start = tracer ? trace_recorder::now() : 0;
         metadata_t metadata;
         byte_t* buf = arecv.buf.data();
-        size_t offset = util::deserialize(metadata, buf);
-        size_t msg_gut_size = arecv.buf.size() - offset;
+        size_t offset = deserialize_metadata(metadata, buf);
+        
+        // the size of what came in, as a response swaps the buffer out
+        const size_t nbytes = arecv.buf.size();
+        
+        // count the message under the type it carries
+        msg_type_stats& s = stats.types[metadata.msg_type];
+        ++s.received;
+        s.bytes_received += nbytes;
         
         //if this is a response message, handle the response
         int src_rank = arecv.src_rank;
-        if( !metadata.is_response ){ response_handler(buf + offset, metadata, src_rank); }
+        if( !metadata.is_response ){
+            response_handler(buf + offset, nbytes - offset, metadata, src_rank);
+            if( tracer ){
+                tracer->complete("handle request", trace_cat, start, trace_recorder::now(), src_rank,
+                                 metadata.msg_type, static_cast<int64_t>(nbytes));
+            }
+        }
         
         // otherwise, extract the result and stuff into the appropriate
         // message within the structure
         else{
             
-            // fill the message with the non-metadata portion of message
+            // drop responses to messages that are no longer around,
+            // like ones sent before the messages were cleared
+            if( metadata.msg_id >= messages.size() || messages[metadata.msg_id]->did_get_response()
+               || messages[metadata.msg_id]->get_dest_rank() != src_rank ){
+                ++stats.unmatched_responses;
+                return;
+            }
+            
+            // hand the received buffer over to the message, with the
+            // receive buffer pointing past the metadata. The message's old
+            // buffer goes back into the pooled receive, so nothing is copied
             util::raw_handle<message> msg_ = messages[metadata.msg_id];
-            msg_->resize_receive_buffer(msg_gut_size);
-            std::memcpy(msg_->get_receive_buffer(),
-                        buf + offset,
-                        msg_gut_size);
+            msg_->swap_receive_buffer(arecv.buf, offset);
             
             // free the message request; should be done at this point
             MPI_Wait(&msg_->get_mpi_request(), MPI_STATUS_IGNORE);
@@ -177,6 +247,13 @@ namespace distributed {
             // increment the number complete
             msg_->set_response(true);
             increment_number_complete_msgs();
+            
+            // time the round trip under the type of the request
+            stats.types[msg_->get_type()].round_trip.record(MPI_Wtime() - send_times[metadata.msg_id]);
+            if( tracer ){
+                tracer->complete("receive response", trace_cat, start, trace_recorder::now(), src_rank,
+                                 metadata.msg_type, static_cast<int64_t>(nbytes));
+            }
         }
         
     }
@@ -193,6 +270,74 @@ namespace distributed {
         ++num_complete;
     }
     
+    // write/read metadata using a fixed layout
+    size_t msg_manager2::metadata_byte_content() {
+        return sizeof(metadata_wire_t);
+    }
+    size_t msg_manager2::serialize_metadata(const metadata_t& metadata, byte_t* buffer, size_t start_idx) {
+        metadata_wire_t wire;
+        wire.is_response = metadata.is_response ? 1 : 0;
+        wire.reserved[0] = wire.reserved[1] = wire.reserved[2] = 0;
+        wire.msg_type    = static_cast<int32_t>(metadata.msg_type);
+        wire.mngr_id     = static_cast<uint32_t>(metadata.mngr_id);
+        wire.msg_id      = static_cast<uint32_t>(metadata.msg_id);
+        return util::serialize(wire, buffer, start_idx);
+    }
+    size_t msg_manager2::deserialize_metadata(metadata_t& metadata, const byte_t* buffer, size_t start_idx) {
+        metadata_wire_t wire;
+        start_idx = util::deserialize(wire, buffer, start_idx);
+        metadata.is_response = (wire.is_response != 0);
+        metadata.msg_type    = wire.msg_type;
+        metadata.mngr_id     = wire.mngr_id;
+        metadata.msg_id      = wire.msg_id;
+        return start_idx;
+    }
+    
+    // methods to get objects from/return objects to the pools
+    void msg_manager2::acquire_message(uniq_msg_t& msg) {
+        message* msg_ = msg_pool.acquire();
+        msg_->reset();
+        msg.adopt(msg_);
+    }
+    void msg_manager2::release_message(uniq_msg_t& msg) {
+        msg_pool.release(msg.release());
+    }
+    
+    // get the number of sends and receives still in flight
+    size_t msg_manager2::num_pending_sends() const {
+        return response_q.size();
+    }
+    size_t msg_manager2::num_pending_receives() const {
+        return recv_q.size();
+    }
+    
+    // get counters for the reuse of message and receive objects
+    const util::pool_stats& msg_manager2::get_message_pool_stats() const {
+        return msg_pool.get_stats();
+    }
+    const util::pool_stats& msg_manager2::get_recv_pool_stats() const {
+        return recv_pool.get_stats();
+    }
+    
+    // get/reset/print the traffic counters
+    const comm_stats& msg_manager2::get_comm_stats() const {
+        return stats;
+    }
+    void msg_manager2::reset_comm_stats() {
+        stats.clear();
+    }
+    void msg_manager2::print_comm_stats(FILE* out, const char* name) const {
+        stats.print(out, name);
+        fprintf(out, "  now pending sends %zu, pending receives %zu, outstanding requests %zu\n",
+                num_pending_sends(), num_pending_receives(), num_messages() - num_complete);
+    }
+    
+    // record the messages in a trace recorder
+    void msg_manager2::set_tracer(trace_recorder* rec, const char* category) {
+        tracer    = rec;
+        trace_cat = category;
+    }
+    
     // set/get the tag for this class
     void msg_manager2::set_manager_tag(int tag_) {
         tag = tag_;
@@ -213,12 +358,13 @@ namespace distributed {
         int flag;
         struct probe_t probe_;
         
-        // perform the non-blocking probe
-        probe_.error_code = MPI_Iprobe(MPI_ANY_SOURCE,
-                                       tag,
-                                       comm,
-                                       &flag,
-                                       &probe_.status);
+        // perform the non-blocking matched probe
+        probe_.error_code = MPI_Improbe(MPI_ANY_SOURCE,
+                                        tag,
+                                        comm,
+                                        &flag,
+                                        &probe_.handle,
+                                        &probe_.status);
         
         // construct the probe struct instance
         probe_.flag = (flag != 0);
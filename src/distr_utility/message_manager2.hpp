@@ -14,6 +14,9 @@
 #include "distr_message.hpp"
 #include "unique_handle.hpp"
 #include "raw_handle.hpp"
+#include "object_pool.hpp"
+#include "comm_stats.hpp"
+#include "trace_recorder.hpp"
 
 namespace distributed {
     
@@ -54,6 +57,32 @@ namespace distributed {
         // methods for checking progress
         void check_message_completeness(int num2process = 128);
         
+        // write/read metadata using a fixed 16 byte layout with
+        // no struct padding on the wire
+        static size_t metadata_byte_content();
+        static size_t serialize_metadata(const metadata_t& metadata, byte_t* buffer, size_t start_idx = 0);
+        static size_t deserialize_metadata(metadata_t& metadata, const byte_t* buffer, size_t start_idx = 0);
+        
+        // get the number of independent sends and of
+        // receives that are still in flight
+        size_t num_pending_sends() const;
+        size_t num_pending_receives() const;
+        
+        // get counters for the reuse of message and receive objects
+        const util::pool_stats& get_message_pool_stats() const;
+        const util::pool_stats& get_recv_pool_stats() const;
+        
+        // get/reset the counters of the messages sent and received by
+        // this manager, and print them, see comm_stats
+        const comm_stats& get_comm_stats() const;
+        void reset_comm_stats();
+        void print_comm_stats(FILE* out, const char* name) const;
+        
+        // record every send, and the handling of every received
+        // message, as events under the given category (a string
+        // literal) in a trace recorder, or stop with a null recorder
+        void set_tracer(trace_recorder* rec, const char* category);
+        
     protected:
         using uniq_msg_t = util::unique_handle<message>;
         int tag, local_rank;
@@ -66,6 +95,7 @@ namespace distributed {
         struct probe_t {
             int error_code;
             MPI_Status status;
+            MPI_Message handle;
             bool flag;
         };
         
@@ -80,12 +110,39 @@ namespace distributed {
         uniq_msg_t create_indep_message();
         void add_msg_to_response_queue(uniq_msg_t msg);
         
+        // send a message made by create_message, timing the round trip
+        // to its response, or send an independent message and queue
+        // it up until the send completes. Both count the message
+        void send_message(size_t message_id);
+        void send_indep_message(uniq_msg_t msg);
+        
     private:
         
         // queue to store response messages
         std::queue<uniq_msg_t>      response_q;
         std::queue<uniq_arecv_t>    recv_q;
         
+        // pools recycling messages and receives, along with
+        // their byte buffers, from one round to the next
+        util::object_pool<message>      msg_pool;
+        util::object_pool<async_recv>   recv_pool;
+        
+        // traffic counters, and the send times of the messages
+        // waiting on a response
+        comm_stats              stats;
+        std::vector<double>     send_times;
+        
+        // timeline of the messages, if any
+        trace_recorder*         tracer;
+        const char*             trace_cat;
+        
+        // methods to get objects from/return objects to the pools
+        void acquire_message(uniq_msg_t& msg);
+        void release_message(uniq_msg_t& msg);
+        
+        // count a message sent out
+        void record_send(const message& msg);
+        
         // perform nonblocking probe
         probe_t perform_nonblock_probe() const;
         void check_responses_complete();
@@ -94,7 +151,7 @@ namespace distributed {
         void process_recv(async_recv& arecv);
         
         // define virtual method for handling responses
-        virtual void response_handler(byte_t* buf, metadata_t metadata, int src_rank) = 0;
+        virtual void response_handler(byte_t* buf, size_t size, metadata_t metadata, int src_rank) = 0;
         
     };
     
@@ -0,0 +1,65 @@
+//
+//  object_pool.hpp
+//  async_pso
+//
+
+#ifndef object_pool_hpp
+#define object_pool_hpp
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace util {
+
+    // counters describing how well a pool is being reused
+    struct pool_stats {
+        size_t hits;        // acquires served from the free list
+        size_t misses;      // acquires that had to allocate
+        size_t releases;    // objects handed back to the pool
+        size_t in_use;      // objects currently handed out
+    };
+
+    /*
+     Free-list pool for objects that get created and destroyed
+     at a high rate. Released objects are kept around as is, so
+     any buffers they own keep their capacity for the next use.
+     Objects are allocated with new, so an object that is never
+     released can still be deleted normally by its owner.
+     */
+    template<typename T>
+    class object_pool {
+    public:
+
+        // ctor/dtor
+        object_pool(size_t max_free = 1024);
+        ~object_pool() = default;
+
+        // get an object, reusing a released one if possible
+        T* acquire();
+
+        // hand an object back to the pool
+        void release(T* obj);
+
+        // pre-allocate objects for the free list
+        void reserve(size_t num_objects);
+
+        // set the max number of free objects kept around
+        void set_max_free(size_t max_free);
+
+        // get the pool state
+        size_t num_free() const;
+        const pool_stats& get_stats() const;
+
+    private:
+        size_t                          max_free;
+        pool_stats                      stats;
+        std::vector<std::unique_ptr<T>> free_list;
+
+    };
+
+}// end namespace util
+
+#include "object_pool.hxx"
+
+#endif /* object_pool_hpp */
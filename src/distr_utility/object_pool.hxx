@@ -0,0 +1,69 @@
+//
+//  object_pool.hxx
+//  async_pso
+//
+
+#ifndef object_pool_hxx
+#define object_pool_hxx
+
+#define HEADER template<typename T>
+#define CLASS object_pool<T>
+
+#include "object_pool.hpp"
+
+namespace util {
+
+    // ctor/dtor
+    HEADER CLASS::object_pool(size_t max_free_):max_free(max_free_) {
+        stats.hits = stats.misses = stats.releases = stats.in_use = 0;
+    }
+
+    // get an object, reusing a released one if possible
+    HEADER T* CLASS::acquire() {
+        ++stats.in_use;
+        if( free_list.empty() ){
+            ++stats.misses;
+            return new T();
+        }
+        ++stats.hits;
+        T* obj = free_list.back().release();
+        free_list.pop_back();
+        return obj;
+    }
+
+    // hand an object back to the pool
+    HEADER void CLASS::release(T* obj) {
+        if( obj == nullptr ){ return; }
+        ++stats.releases;
+        --stats.in_use;
+        if( free_list.size() < max_free ){ free_list.emplace_back(obj); }
+        else{ delete obj; }
+    }
+
+    // pre-allocate objects for the free list
+    HEADER void CLASS::reserve(size_t num_objects) {
+        while( free_list.size() < num_objects && free_list.size() < max_free ){
+            free_list.emplace_back(new T());
+        }
+    }
+
+    // set the max number of free objects kept around
+    HEADER void CLASS::set_max_free(size_t max_free_) {
+        max_free = max_free_;
+        if( free_list.size() > max_free ){ free_list.resize(max_free); }
+    }
+
+    // get the pool state
+    HEADER size_t CLASS::num_free() const {
+        return free_list.size();
+    }
+    HEADER const pool_stats& CLASS::get_stats() const {
+        return stats;
+    }
+
+}// end namespace util
+
+#undef HEADER
+#undef CLASS
+
+#endif /* object_pool_hxx */
@@ -0,0 +1,188 @@
+//
+//  trace_recorder.cpp
+//  async_pso
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <set>
+#include "trace_recorder.hpp"
+#include "clock_sync.hpp"
+
+namespace distributed {
+
+    // ctor/dtor
+    trace_recorder::trace_recorder():head(0), start_time(0)
+    {}
+
+    // start recording into a buffer of capacity events
+    void trace_recorder::enable(size_t capacity) {
+        events.assign(capacity, event_t());
+        head = 0;
+        start_time = now();
+    }
+    bool trace_recorder::is_enabled() const {
+        return !events.empty();
+    }
+
+    // record events
+    void trace_recorder::complete(const char* name, const char* cat, uint64_t start, uint64_t end,
+                                  int peer, int type, int64_t bytes) {
+        if( events.empty() ){ return; }
+        record(make_event(name, cat, start, end, peer, type, bytes, 'X'));
+    }
+    void trace_recorder::instant(const char* name, const char* cat, int peer, int type, int64_t bytes) {
+        if( events.empty() ){ return; }
+        const uint64_t t = now();
+        record(make_event(name, cat, t, t, peer, type, bytes, 'i'));
+    }
+
+    // fill in an event on the calling thread
+    typename trace_recorder::event_t trace_recorder::make_event(const char* name, const char* cat, uint64_t start,
+                                                              uint64_t end, int peer, int type, int64_t bytes,
+                                                              char phase) {
+        event_t ev;
+        ev.name  = name;
+        ev.cat   = cat;
+        ev.start = start;
+        ev.end   = end;
+        ev.bytes = bytes;
+        ev.tid   = thread_id();
+        ev.peer  = peer;
+        ev.type  = type;
+        ev.phase = phase;
+        return ev;
+    }
+
+    // record an event into the next slot
+    void trace_recorder::record(const event_t& ev) {
+        const uint64_t idx = head.fetch_add(1, std::memory_order_relaxed);
+        events[idx % events.size()] = ev;
+    }
+
+    // get the events recorded since enable
+    size_t trace_recorder::num_recorded() const {
+        return static_cast<size_t>(head.load(std::memory_order_relaxed));
+    }
+    size_t trace_recorder::num_dropped() const {
+        const size_t n = num_recorded();
+        return n > events.size() ? n - events.size() : 0;
+    }
+
+    // get a small id for the calling thread
+    int32_t trace_recorder::thread_id() {
+        static std::atomic<int32_t> next_id(0);
+        thread_local int32_t id = next_id++;
+        return id;
+    }
+
+    // align the clock of this rank to the one of rank 0
+    int64_t trace_recorder::clock_offset(MPI_Comm comm) {
+        return distributed::clock_offset(comm, [](){ return static_cast<int64_t>(now()); });
+    }
+
+    // format the events of this rank as trace JSON
+    void trace_recorder::format(std::string& out, int rank, int64_t offset, int64_t origin) const {
+        char line[512];
+        const size_t n = std::min(num_recorded(), events.size());
+        const uint64_t first = num_recorded() - n;
+
+        // name the process and its threads
+        snprintf(line, sizeof(line), ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%i,\"tid\":0,"
+                 "\"args\":{\"name\":\"rank %i\"}}", rank, rank);
+        out += line;
+        snprintf(line, sizeof(line), ",\n{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":%i,\"tid\":0,"
+                 "\"args\":{\"sort_index\":%i}}", rank, rank);
+        out += line;
+        if( num_dropped() ){
+            snprintf(line, sizeof(line), ",\n{\"name\":\"process_labels\",\"ph\":\"M\",\"pid\":%i,\"tid\":0,"
+                     "\"args\":{\"labels\":\"%zu oldest events dropped\"}}", rank, num_dropped());
+            out += line;
+        }
+        std::set<int32_t> tids;
+        for(uint64_t k = first; k < first + n; ++k){ tids.insert(events[k % events.size()].tid); }
+        for(int32_t tid: tids){
+            snprintf(line, sizeof(line), ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%i,\"tid\":%i,"
+                     "\"args\":{\"name\":\"thread %i\"}}", rank, tid, tid);
+            out += line;
+        }
+
+        // the events, oldest first, with times in microseconds
+        for(uint64_t k = first; k < first + n; ++k){
+            const event_t& ev = events[k % events.size()];
+            const double ts = 1e-3 * static_cast<double>(static_cast<int64_t>(ev.start) + offset - origin);
+            int len = 0;
+            if( ev.phase == 'X' ){
+                len = snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%i,"
+                               "\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f", ev.name, ev.cat, rank, ev.tid, ts,
+                               1e-3 * static_cast<double>(ev.end - ev.start));
+            }else{
+                len = snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\","
+                               "\"pid\":%i,\"tid\":%i,\"ts\":%.3f", ev.name, ev.cat, rank, ev.tid, ts);
+            }
+            out.append(line, len);
+
+            // add whatever details the event has
+            std::string args;
+            if( ev.peer >= 0 ){ args += ",\"peer\":" + std::to_string(ev.peer); }
+            if( ev.type >= 0 ){ args += ",\"type\":" + std::to_string(ev.type); }
+            if( ev.bytes >= 0 ){ args += ",\"bytes\":" + std::to_string(ev.bytes); }
+            if( !args.empty() ){ out += ",\"args\":{" + args.substr(1) + "}"; }
+            out += "}";
+        }
+    }
+
+    // write the events of all ranks to one file on rank 0
+    void trace_recorder::write(MPI_Comm comm_, const std::string& file_name) const {
+
+        // align the clocks on a private communicator, so nothing
+        // else in flight can match these messages
+        MPI_Comm comm;
+        MPI_Comm_dup(comm_, &comm);
+        int rank = 0, size = 1;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &size);
+        const int64_t offset = clock_offset(comm);
+
+        // times start at the earliest aligned start of a recording
+        int64_t start = is_enabled() ? static_cast<int64_t>(start_time) + offset : std::numeric_limits<int64_t>::max();
+        int64_t origin = 0;
+        MPI_Allreduce(&start, &origin, 1, MPI_INT64_T, MPI_MIN, comm);
+
+        std::string chunk;
+        if( is_enabled() ){ format(chunk, rank, offset, origin); }
+
+        if( rank != 0 ){
+            MPI_Send(chunk.data(), static_cast<int>(chunk.size()), MPI_CHAR, 0, 1, comm);
+        }else{
+
+            // gather one rank at a time, so only one chunk is held at once,
+            // dropping the comma in front of the very first event
+            FILE* out = fopen(file_name.c_str(), "w");
+            bool first = true;
+            if( out ){ fprintf(out, "{\"traceEvents\":["); }
+            for(int r = 0; r < size; ++r){
+                if( r > 0 ){
+                    MPI_Status status;
+                    int count = 0;
+                    MPI_Probe(r, 1, comm, &status);
+                    MPI_Get_count(&status, MPI_CHAR, &count);
+                    chunk.resize(count);
+                    MPI_Recv(&chunk[0], count, MPI_CHAR, r, 1, comm, MPI_STATUS_IGNORE);
+                }
+                if( out && !chunk.empty() ){
+                    const size_t skip = first ? 1 : 0;
+                    fwrite(chunk.data() + skip, 1, chunk.size() - skip, out);
+                    first = false;
+                }
+            }
+            if( out ){
+                fprintf(out, "\n],\"displayTimeUnit\":\"ms\"}\n");
+                fclose(out);
+            }
+        }
+        MPI_Comm_free(&comm);
+    }
+
+}
@@ -0,0 +1,102 @@
+//
+//  trace_recorder.hpp
+//  async_pso
+//
+
+#ifndef trace_recorder_hpp
+#define trace_recorder_hpp
+
+#include <mpi.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace distributed {
+
+    /*
+     Per-rank recorder of timeline events, written out as one
+     Chrome trace (JSON) file for all ranks that chrome://tracing
+     and Perfetto can open, with one process per rank and one
+     track per thread. Events go into a fixed size ring buffer
+     with a single atomic increment per event, so any thread can
+     record without a lock and the oldest events get overwritten
+     once the buffer is full. Event names and categories must be
+     string literals, as only the pointers are kept.
+     */
+    class trace_recorder {
+    public:
+
+        // ctor/dtor
+        trace_recorder();
+        ~trace_recorder() = default;
+
+        // start recording into a buffer of capacity events, dropping
+        // anything recorded so far, or stop recording with 0. Must not
+        // be called while other threads may be recording
+        void enable(size_t capacity);
+        bool is_enabled() const;
+
+        // get the current time of the trace clock in nanoseconds
+        static uint64_t now() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        // record an event that ran from start to end, or one that happened
+        // at a single point in time, with an optional peer rank, message
+        // type and byte count (-1 leaves them out)
+        void complete(const char* name, const char* cat, uint64_t start, uint64_t end,
+                      int peer = -1, int type = -1, int64_t bytes = -1);
+        void instant(const char* name, const char* cat, int peer = -1, int type = -1, int64_t bytes = -1);
+
+        // get the events recorded since enable and how many
+        // of them were overwritten
+        size_t num_recorded() const;
+        size_t num_dropped() const;
+
+        // write the events of all ranks to one file on rank 0. The clock
+        // of every rank is aligned to the one of rank 0 by the round trip
+        // with the smallest delay out of a few, and times are shown from
+        // the moment the first rank started recording. Collective over
+        // comm, where ranks that are not recording add no events
+        void write(MPI_Comm comm, const std::string& file_name) const;
+
+    private:
+
+        struct event_t {
+            const char* name;
+            const char* cat;
+            uint64_t    start, end;
+            int64_t     bytes;
+            int32_t     tid, peer, type;
+            char        phase;          // 'X' for complete, 'i' for instant
+        };
+
+        std::vector<event_t>    events;
+        std::atomic<uint64_t>   head;
+        uint64_t                start_time;
+
+        // fill in an event on the calling thread and
+        // record it into the next slot
+        static event_t make_event(const char* name, const char* cat, uint64_t start, uint64_t end,
+                                  int peer, int type, int64_t bytes, char phase);
+        void record(const event_t& ev);
+
+        // get a small id for the calling thread
+        static int32_t thread_id();
+
+        // get the offset of the clock of this rank to the one of rank 0
+        static int64_t clock_offset(MPI_Comm comm);
+
+        // format the events of this rank as trace JSON, with every line
+        // starting with a comma and times shifted by offset - origin
+        void format(std::string& out, int rank, int64_t offset, int64_t origin) const;
+
+    };
+
+}
+
+#endif /* trace_recorder_hpp */
@@ -94,6 +94,11 @@ namespace util {
         // free
         void free();
         
+        // take ownership of a raw pointer, or give up ownership
+        // of the current one without deleting it
+        void adopt(T* ptr);
+        T* release();
+        
     private:
         mutable std::unique_ptr<T> ref;
         
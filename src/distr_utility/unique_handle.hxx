@@ -123,6 +123,13 @@ namespace util {
         ref = nullptr;
     }
     
+    HEADER void CLASS::adopt(T* ptr) {
+        ref.reset(ptr);
+    }
+    HEADER T* CLASS::release() {
+        return ref.release();
+    }
+    
 }// end namespace util
 
 
@@ -22,8 +22,10 @@ struct quadratic {
 
 int main(int argc, const char * argv[]) {
     
-    // initialize the MPI stuff
-    MPI_Init(nullptr, nullptr);
+    // initialize the MPI stuff. Worker threads never make MPI calls,
+    // but a communication progress thread may, one call at a time
+    int thread_support;
+    MPI_Init_thread(nullptr, nullptr, MPI_THREAD_SERIALIZED, &thread_support);
     
     // get the local rank
     int local_rank;
@@ -59,14 +61,16 @@ int main(int argc, const char * argv[]) {
         printf("Rank(%i): Starting the run\n", local_rank);
     }
     double t1 = MPI_Wtime();
-    // do particle swarm iterations
-    for(int i = 0; i < num_iterations; ++i){
-        swarm_.iterate();
-    }
+    // do particle swarm iterations until the swarm stops making progress
+    pso::termination_criteria criteria;
+    criteria.max_iterations     = num_iterations;
+    criteria.stall_iterations   = 1000;
+    pso::stop_reason_t reason = swarm_.run(criteria);
     double t2 = MPI_Wtime();
     
     // print the result
     if( local_rank == 0 ){
+        printf("Rank(%i): Stopped on %s\n", local_rank, pso::to_string(reason));
         printf("Rank(%i): Runtime is %0.5es\n", local_rank, t2 - t1);
         printf("Rank(%i): fval^* = %0.5e\n", local_rank, swarm_.get_best_objective_value());
         printf("Rank(%i): x^*    = [ ", local_rank);
@@ -77,7 +81,11 @@ int main(int argc, const char * argv[]) {
         printf("]\n");
     }
     
+    // print where the time went, in builds with the profiler
+    swarm_.get_profiler().report(MPI_COMM_WORLD, stdout, "the sync swarm");
+    
     // finalize
+    swarm_.finalize();
     MPI_Finalize();
     return 0;
 }
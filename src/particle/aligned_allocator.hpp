@@ -0,0 +1,57 @@
+//
+//  aligned_allocator.hpp
+//  async_pso
+//
+
+#ifndef aligned_allocator_hpp
+#define aligned_allocator_hpp
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace util {
+
+    /*
+     Minimal allocator that hands out memory aligned
+     to a given byte boundary (a cache line by default)
+     so contiguous particle data can be used with
+     aligned vector loads/stores
+     */
+    template<typename T, size_t Align = 64>
+    class aligned_allocator {
+    public:
+
+        // type aliases required by the allocator concept
+        using value_type = T;
+        template<typename U> struct rebind { using other = aligned_allocator<U, Align>; };
+
+        // ctor/dtor
+        aligned_allocator() = default;
+        template<typename U> aligned_allocator(const aligned_allocator<U, Align>&) {}
+
+        // allocation methods
+        T* allocate(size_t n) {
+            void* ptr = nullptr;
+            if( posix_memalign(&ptr, Align, n * sizeof(T)) != 0 ){
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(ptr);
+        }
+        void deallocate(T* ptr, size_t) {
+            std::free(ptr);
+        }
+
+        // allocators are stateless, so all are equal
+        template<typename U> bool operator==(const aligned_allocator<U, Align>&) const { return true; }
+        template<typename U> bool operator!=(const aligned_allocator<U, Align>&) const { return false; }
+    };
+
+    // convenient alias for an aligned vector
+    template<typename T, size_t Align = 64>
+    using aligned_vector = std::vector<T, aligned_allocator<T, Align>>;
+
+}// end namespace util
+
+#endif /* aligned_allocator_hpp */
@@ -0,0 +1,385 @@
+//
+//  checkpoint.cpp
+//  async_pso
+//
+
+#include "checkpoint.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace pso {
+    namespace checkpoint {
+
+        static const char magic[8] = {'A','P','S','O','C','K','P','T'};
+
+        // get the file names of some rank's file of an epoch and of the manifest
+        std::string file_name(const std::string& prefix, size_t epoch, int rank) {
+            return prefix + "." + std::to_string(epoch) + "." + std::to_string(rank) + ".ckpt";
+        }
+        std::string manifest_name(const std::string& prefix) {
+            return prefix + ".manifest";
+        }
+
+        // read the manifest
+        bool read_manifest(const std::string& prefix, manifest_t& manifest) {
+            FILE* file = std::fopen(manifest_name(prefix).c_str(), "r");
+            if( !file ){ return false; }
+            unsigned int fversion = 0, num_ranks = 0;
+            unsigned long long epoch = 0, iteration = 0;
+            const bool ok = std::fscanf(file, "APSOCKPT %u epoch %llu iteration %llu ranks %u",
+                                        &fversion, &epoch, &iteration, &num_ranks) == 4;
+            std::fclose(file);
+            if( !ok || fversion != version || num_ranks == 0 ){ return false; }
+            manifest.epoch      = epoch;
+            manifest.iteration  = iteration;
+            manifest.num_ranks  = num_ranks;
+            return true;
+        }
+
+        // write the manifest to a temporary file, then move it in place
+        bool write_manifest(const std::string& prefix, const manifest_t& manifest) {
+            const std::string fname = manifest_name(prefix), tmp = fname + ".tmp";
+            FILE* file = std::fopen(tmp.c_str(), "w");
+            if( !file ){ return false; }
+            bool ok = std::fprintf(file, "APSOCKPT %u\nepoch %llu\niteration %llu\nranks %u\n", version,
+                                   static_cast<unsigned long long>(manifest.epoch),
+                                   static_cast<unsigned long long>(manifest.iteration), manifest.num_ranks) > 0;
+            ok = (std::fclose(file) == 0) && ok;
+            return ok && std::rename(tmp.c_str(), fname.c_str()) == 0;
+        }
+
+        // read and check the header and best position of a file
+        static bool read_header(FILE* file, header_t& header, std::vector<double>& best_pos) {
+            if( std::fread(&header, sizeof(header_t), 1, file) != 1 ){ return false; }
+            if( std::memcmp(header.magic, magic, sizeof(magic)) != 0 ){ return false; }
+            if( header.version != version ){ return false; }
+            best_pos.resize(header.dim);
+            return std::fread(best_pos.data(), sizeof(double), header.dim, file) == header.dim;
+        }
+
+        // replace the particles of the block with this rank's share
+        bool read(const std::string& prefix, int rank, int num_ranks,
+                  particle_block& block, state_t& state)
+        {
+            // the manifest tells us the epoch to read and how many ranks wrote it
+            manifest_t manifest;
+            if( !read_manifest(prefix, manifest) ){ return false; }
+
+            // go through the headers of all files to get the particle
+            // counts and the best estimate, where every file has to be
+            // from the committed epoch
+            header_t header;
+            std::vector<double> pos;
+            const int old_ranks = static_cast<int>(manifest.num_ranks);
+            std::vector<uint64_t> counts(old_ranks);
+            state.epoch     = manifest.epoch;
+            state.num_ranks = manifest.num_ranks;
+            state.iteration = manifest.iteration;
+            state.best_fval = std::numeric_limits<double>::max();
+            state.best_pos.clear();
+            for(int r = 0; r < old_ranks; ++r){
+                FILE* file = std::fopen(file_name(prefix, manifest.epoch, r).c_str(), "rb");
+                if( !file ){ return false; }
+                bool ok = read_header(file, header, pos);
+                std::fclose(file);
+                if( !ok || header.dim != block.num_dims() || header.particle_bytes != block.packed_bytes()
+                   || header.rank != static_cast<uint32_t>(r) || header.num_ranks != manifest.num_ranks
+                   || header.epoch != manifest.epoch || header.iteration < manifest.iteration ){ return false; }
+
+                counts[r] = header.num_particles;
+                if( r == 0 || header.best_fval < state.best_fval ){
+                    state.best_fval = header.best_fval;
+                    state.best_pos  = pos;
+                }
+            }
+
+            // our share of the particles over all files
+            uint64_t total = 0;
+            for(uint64_t c: counts){ total += c; }
+            const uint64_t first = total * rank / num_ranks;
+            const uint64_t last  = total * (rank + 1) / num_ranks;
+
+            // read the particles of the files overlapping our share
+            const size_t nbytes = block.packed_bytes();
+            std::vector<unsigned char> buffer((last - first) * nbytes);
+            unsigned char* b = buffer.data();
+            uint64_t offset = 0;
+            for(int r = 0; r < old_ranks && offset < last; offset += counts[r], ++r){
+                const uint64_t lo = std::max(first, offset);
+                const uint64_t hi = std::min(last, offset + counts[r]);
+                if( lo >= hi ){ continue; }
+
+                FILE* file = std::fopen(file_name(prefix, manifest.epoch, r).c_str(), "rb");
+                if( !file ){ return false; }
+                const long start = static_cast<long>(sizeof(header_t) + header.dim*sizeof(double) + (lo - offset)*nbytes);
+                const size_t size = (hi - lo) * nbytes;
+                const bool ok = std::fseek(file, start, SEEK_SET) == 0 && std::fread(b, 1, size, file) == size;
+                std::fclose(file);
+                if( !ok ){ return false; }
+                b += size;
+            }
+
+            // only swap the particles in once everything was read
+            block.clear();
+            for(uint64_t k = 0; k < last - first; ++k){
+                block.unpack(&buffer[k*nbytes]);
+            }
+            return true;
+        }
+
+    }// end namespace checkpoint
+
+    // ctor/dtor
+    checkpoint_writer::checkpoint_writer():prefix("pso"), busy(false), nwritten(0), nfailed(0),
+    has_pending(false), has_committed(false), pending_ok(false), rank(0), ncommitted(0),
+    has_candidate(false), candidate_ok(false), agreed(-1), named(-1), agree_req(MPI_REQUEST_NULL),
+    agree_epoch(0), comm_rank(0), comm_size(1)
+    {
+        // nothing was agreed on yet, but no rank finished either
+        std::fill(agree_vals, agree_vals + 7, 0);
+        agree_vals[0] = 1;
+    }
+    checkpoint_writer::~checkpoint_writer() {
+        wait();
+    }
+
+    // set the prefix of the checkpoint files
+    void checkpoint_writer::set_prefix(const std::string& prefix_) {
+        prefix = prefix_;
+    }
+    const std::string& checkpoint_writer::get_prefix() const {
+        return prefix;
+    }
+
+    // check if the previous checkpoint is still being written
+    bool checkpoint_writer::is_busy() const {
+        return busy;
+    }
+
+    // snapshot the block and state, and write them out in the background
+    bool checkpoint_writer::write(int rank_, int num_ranks, const particle_block& block, size_t epoch,
+                                  size_t iteration, double best_fval, const std::vector<double>& best_pos)
+    {
+        if( busy ){ return false; }
+        if( worker.joinable() ){ worker.join(); }
+        rank = rank_;
+
+        // fill in the header
+        checkpoint::header_t header;
+        std::memcpy(header.magic, checkpoint::magic, sizeof(header.magic));
+        header.version          = checkpoint::version;
+        header.rank             = static_cast<uint32_t>(rank);
+        header.num_ranks        = static_cast<uint32_t>(num_ranks);
+        header.dim              = static_cast<uint32_t>(block.num_dims());
+        header.num_particles    = block.size();
+        header.epoch            = epoch;
+        header.iteration        = iteration;
+        header.best_fval        = best_fval;
+        header.particle_bytes   = block.packed_bytes();
+
+        // copy everything into the snapshot, padding the best
+        // position with zeros if there is no estimate yet
+        const size_t pos_bytes = header.dim*sizeof(double);
+        snapshot.resize(sizeof(header) + pos_bytes + block.size()*header.particle_bytes);
+        unsigned char* b = snapshot.data();
+        std::memcpy(b, &header, sizeof(header));    b += sizeof(header);
+        std::memset(b, 0, pos_bytes);
+        std::memcpy(b, best_pos.data(), std::min(best_pos.size(), size_t(header.dim))*sizeof(double));
+        b += pos_bytes;
+        for(size_t k = 0; k < block.size(); ++k){
+            b += block.pack(k, b);
+        }
+
+        pending.epoch       = epoch;
+        pending.iteration   = iteration;
+        pending.num_ranks   = header.num_ranks;
+        has_pending         = true;
+        pending_ok          = false;
+
+        busy = true;
+        worker = std::thread(&checkpoint_writer::write_file, this, checkpoint::file_name(prefix, epoch, rank));
+        return true;
+    }
+
+    // wait for the current write to finish
+    void checkpoint_writer::wait() {
+        if( worker.joinable() ){ worker.join(); }
+    }
+
+    // commit the epoch of the current write once every rank wrote it
+    bool checkpoint_writer::commit(MPI_Comm comm) {
+        wait();
+
+        // agree on whether every rank wrote its file of the same epoch,
+        // with the success, the epoch and the negated epoch reduced by a min
+        long long vals[3] = { has_pending && pending_ok ? 1 : 0,
+                              has_pending ? static_cast<long long>(pending.epoch) : -1,
+                              has_pending ? -static_cast<long long>(pending.epoch) : 1 };
+        MPI_Allreduce(MPI_IN_PLACE, vals, 3, MPI_LONG_LONG, MPI_MIN, comm);
+        bool ok = vals[0] == 1 && vals[1] == -vals[2];
+
+        // rank 0 names the epoch in the manifest, and only once that is
+        // in place do the ranks let go of the epoch committed before
+        MPI_Comm_rank(comm, &comm_rank);
+        MPI_Comm_size(comm, &comm_size);
+        if( ok ){
+            int was_named = 0;
+            if( comm_rank == 0 ){ was_named = checkpoint::write_manifest(prefix, pending) ? 1 : 0; }
+            MPI_Bcast(&was_named, 1, MPI_INT, 0, comm);
+            ok = was_named != 0;
+        }
+        if( has_pending ){
+            if( ok ){
+                if( has_committed && committed.epoch != pending.epoch ){ remove_files(committed); }
+                committed     = pending;
+                has_committed = true;
+                ++ncommitted;
+            }else if( !has_committed || committed.epoch != pending.epoch ){
+                std::remove(checkpoint::file_name(prefix, pending.epoch, rank).c_str());
+            }
+            has_pending = false;
+        }
+        return ok;
+    }
+
+    // start agreeing on taking an epoch
+    void checkpoint_writer::start_agreement(MPI_Comm comm, size_t epoch, bool finished) {
+        wait();
+        MPI_Comm_rank(comm, &comm_rank);
+        MPI_Comm_size(comm, &comm_size);
+
+        // the last write commits at this agreement if all ranks took its
+        // epoch, and is of no use otherwise
+        if( has_pending ){
+            if( agreed == static_cast<long long>(pending.epoch) ){
+                candidate     = pending;
+                candidate_ok  = pending_ok;
+                has_candidate = true;
+            }else{
+                std::remove(checkpoint::file_name(prefix, pending.epoch, comm_rank).c_str());
+            }
+            has_pending = false;
+        }
+
+        // everything is reduced by a min: whether every rank takes the
+        // epoch, whether every rank finished, whether every rank wrote
+        // the candidate, its epoch and negated epoch to check they all
+        // have the same, the epoch rank 0 named in the manifest and the
+        // iteration of the candidate, which ranks may take at different
+        // iterations of their own
+        const long long cepoch = has_candidate ? static_cast<long long>(candidate.epoch) : -1;
+        agree_epoch   = epoch;
+        agree_vals[0] = finished ? 0 : 1;
+        agree_vals[1] = finished ? 1 : 0;
+        agree_vals[2] = has_candidate && candidate_ok ? 1 : 0;
+        agree_vals[3] = cepoch;
+        agree_vals[4] = -cepoch;
+        agree_vals[5] = comm_rank == 0 ? named : std::numeric_limits<long long>::max();
+        agree_vals[6] = has_candidate ? static_cast<long long>(candidate.iteration) : 0;
+        MPI_Iallreduce(MPI_IN_PLACE, agree_vals, 7, MPI_LONG_LONG, MPI_MIN, comm, &agree_req);
+    }
+
+    // check if the agreement is over
+    bool checkpoint_writer::test_agreement() {
+        if( agree_req == MPI_REQUEST_NULL ){ return true; }
+        int done = 0;
+        MPI_Test(&agree_req, &done, MPI_STATUS_IGNORE);
+        if( done ){ finish_agreement(); }
+        return done != 0;
+    }
+
+    // handle the outcome of an agreement
+    void checkpoint_writer::finish_agreement() {
+
+        // commit the candidate if every rank wrote it, with rank 0 naming
+        // it in the manifest, or drop this rank's file of it otherwise
+        if( has_candidate ){
+            if( agree_vals[2] == 1 && agree_vals[3] == -agree_vals[4] ){
+                candidate.iteration = static_cast<size_t>(agree_vals[6]);
+                if( comm_rank == 0 && checkpoint::write_manifest(prefix, candidate) ){
+                    named = static_cast<long long>(candidate.epoch);
+                }
+                if( has_committed ){ superseded.push_back(committed); }
+                committed     = candidate;
+                has_committed = true;
+                ++ncommitted;
+            }else{
+                std::remove(checkpoint::file_name(prefix, candidate.epoch, comm_rank).c_str());
+            }
+            has_candidate = false;
+        }
+
+        // the epochs before the one in the manifest are of no use anymore
+        prune(agree_vals[5]);
+        if( agree_vals[0] == 1 ){ agreed = static_cast<long long>(agree_epoch); }
+    }
+
+    // outcome of the last agreement
+    bool checkpoint_writer::all_taking() const {
+        return agree_vals[0] == 1;
+    }
+    bool checkpoint_writer::all_finished() const {
+        return agree_vals[1] == 1;
+    }
+
+    // remove the files of the epochs before the one in the manifest
+    void checkpoint_writer::finish_agreements(MPI_Comm comm) {
+        long long last = named;
+        MPI_Bcast(&last, 1, MPI_LONG_LONG, 0, comm);
+        prune(last);
+    }
+
+    // take the epoch restarted from as the last one committed
+    void checkpoint_writer::set_committed(const checkpoint::state_t& state) {
+        committed.epoch     = state.epoch;
+        committed.iteration = state.iteration;
+        committed.num_ranks = static_cast<uint32_t>(state.num_ranks);
+        has_committed       = true;
+        named               = static_cast<long long>(state.epoch);
+    }
+
+    // remove the files of the epochs before some epoch
+    void checkpoint_writer::prune(long long epoch) {
+        size_t n = 0;
+        for(size_t k = 0; k < superseded.size(); ++k){
+            if( static_cast<long long>(superseded[k].epoch) < epoch ){ remove_files(superseded[k]); }
+            else{ superseded[n++] = superseded[k]; }
+        }
+        superseded.resize(n);
+    }
+    void checkpoint_writer::remove_files(const checkpoint::manifest_t& epoch) {
+        for(uint32_t r = comm_rank; r < epoch.num_ranks; r += comm_size){
+            std::remove(checkpoint::file_name(prefix, epoch.epoch, r).c_str());
+        }
+    }
+
+    // write the snapshot to a temporary file, then move it in place
+    void checkpoint_writer::write_file(std::string fname) {
+        const std::string tmp = fname + ".tmp";
+        bool ok = false;
+        FILE* file = std::fopen(tmp.c_str(), "wb");
+        if( file ){
+            ok = std::fwrite(snapshot.data(), 1, snapshot.size(), file) == snapshot.size();
+            ok = (std::fclose(file) == 0) && ok;
+            ok = ok && std::rename(tmp.c_str(), fname.c_str()) == 0;
+        }
+        if( ok ){ ++nwritten; }
+        else{ ++nfailed; }
+        pending_ok = ok;
+        busy = false;
+    }
+
+    // get the number of checkpoints written, failed and committed
+    size_t checkpoint_writer::num_written() const {
+        return nwritten;
+    }
+    size_t checkpoint_writer::num_failed() const {
+        return nfailed;
+    }
+    size_t checkpoint_writer::num_committed() const {
+        return ncommitted;
+    }
+
+}// end namespace pso
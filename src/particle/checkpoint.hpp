@@ -0,0 +1,212 @@
+//
+//  checkpoint.hpp
+//  async_pso
+//
+
+#ifndef checkpoint_hpp
+#define checkpoint_hpp
+
+#include <mpi.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "particle_block.hpp"
+
+namespace pso {
+
+    /*
+     Checkpoints of a swarm partition, taken by all ranks and
+     tagged with a common epoch. Each rank writes
+     its own binary file <prefix>.<epoch>.<rank>.ckpt laid out as
+
+        header_t | best position (dim doubles) | packed particles
+
+     in the byte order of the machine. Particles are stored with
+     particle_block::pack, which includes the random stream and
+     step of each particle, so a particle picks up its random
+     sequence right where it left off after a restart.
+
+     An epoch only counts once every rank wrote its file, at which
+     point rank 0 names it in the text file <prefix>.manifest along
+     with the earliest iteration any rank took it at, and restarts
+     only ever read the epoch in the manifest.
+     */
+    namespace checkpoint {
+
+        // file format version
+        static constexpr uint32_t version = 2;
+
+        // fixed size header at the start of every file
+        struct header_t {
+            char        magic[8];       // "APSOCKPT"
+            uint32_t    version;
+            uint32_t    rank;
+            uint32_t    num_ranks;
+            uint32_t    dim;
+            uint64_t    num_particles;
+            uint64_t    epoch;
+            uint64_t    iteration;
+            double      best_fval;
+            uint64_t    particle_bytes; // bytes per packed particle
+        };
+
+        // committed epoch, as named in the manifest, where the
+        // iteration is the earliest one over the files
+        struct manifest_t {
+            uint64_t    epoch;
+            uint64_t    iteration;
+            uint32_t    num_ranks;
+        };
+
+        // swarm wide state stored along with the particles
+        struct state_t {
+            size_t              epoch;
+            size_t              num_ranks;  // ranks that wrote the epoch
+            size_t              iteration;
+            double              best_fval;
+            std::vector<double> best_pos;
+        };
+
+        // get the file names of some rank's file of an epoch and of the manifest
+        std::string file_name(const std::string& prefix, size_t epoch, int rank);
+        std::string manifest_name(const std::string& prefix);
+
+        // read/write the manifest, where the write goes to a temporary
+        // file that is then renamed over the old manifest
+        bool read_manifest(const std::string& prefix, manifest_t& manifest);
+        bool write_manifest(const std::string& prefix, const manifest_t& manifest);
+
+        // replace the particles of the block with this rank's share of
+        // the particles of the last committed epoch, which may have been
+        // written by any number of ranks, where the particles of all files
+        // are split into contiguous even ranges. The state gets the epoch,
+        // its iteration and the best estimate over all files. Returns false
+        // if there is no manifest, or a file is missing, does not match the
+        // block, has an epoch or rank count other than the one in the
+        // manifest or is from before its iteration, leaving the block untouched
+        bool read(const std::string& prefix, int rank, int num_ranks,
+                  particle_block& block, state_t& state);
+
+    }// end namespace checkpoint
+
+    /*
+     Class writing checkpoints off of the critical path. A
+     write packs the block into a snapshot buffer, which is a
+     copy about the size of the block, and a background thread
+     writes it out to a temporary file that is then renamed, so
+     a file on disk is always a complete checkpoint. A commit, or
+     an agreement that does not block the ranks, then makes the
+     epoch of the write the one restarts use.
+     */
+    class checkpoint_writer {
+    public:
+
+        // ctor/dtor
+        checkpoint_writer();
+        ~checkpoint_writer();
+
+        // set the prefix of the checkpoint files
+        void set_prefix(const std::string& prefix);
+        const std::string& get_prefix() const;
+
+        // check if the previous checkpoint is still being written
+        bool is_busy() const;
+
+        // snapshot the block and state as this rank's part of an epoch,
+        // and write them out in the background. Returns false without
+        // doing anything if the previous checkpoint is still being written
+        bool write(int rank, int num_ranks, const particle_block& block, size_t epoch,
+                   size_t iteration, double best_fval, const std::vector<double>& best_pos);
+
+        // wait for the current write to finish
+        void wait();
+
+        // wait for the current write and commit its epoch if every rank
+        // of the communicator wrote its file for the same epoch, in which
+        // case rank 0 writes the manifest and every rank then removes its
+        // file of the epoch committed before. The file of an epoch that
+        // did not commit is removed instead. Collective, and returns
+        // whether an epoch was committed
+        bool commit(MPI_Comm comm);
+
+        // start agreeing with the other ranks of the communicator on
+        // taking the given epoch, or on none if this rank finished,
+        // without waiting on them. The agreement also commits the epoch
+        // all ranks took before if every rank wrote it, and tells the
+        // ranks which epoch rank 0 last named in the manifest, so they
+        // remove their files of the epochs before it. Waits for the current
+        // write, and the last agreement has to be over. Collective
+        void start_agreement(MPI_Comm comm, size_t epoch, bool finished);
+
+        // check if the agreement is over, handling its outcome when it
+        // is, which on rank 0 includes writing the manifest
+        bool test_agreement();
+
+        // outcome of the last agreement, which is whether every rank
+        // takes its epoch and whether every rank finished
+        bool all_taking() const;
+        bool all_finished() const;
+
+        // once every rank finished, remove this rank's files of the
+        // epochs before the one named in the manifest. Collective
+        void finish_agreements(MPI_Comm comm);
+
+        // take the epoch a swarm restarted from as the one committed
+        // before, so its files are removed by the next commit
+        void set_committed(const checkpoint::state_t& state);
+
+        // get the number of checkpoints written, the number of writes
+        // that failed and the number of epochs committed
+        size_t num_written() const;
+        size_t num_failed() const;
+        size_t num_committed() const;
+
+    private:
+
+        // internal state
+        std::string                 prefix;
+        std::vector<unsigned char>  snapshot;
+        std::thread                 worker;
+        std::atomic<bool>           busy;
+        std::atomic<size_t>         nwritten, nfailed;
+
+        // the epoch being written and whether it made it to disk, and
+        // the last epoch this writer committed, if any
+        checkpoint::manifest_t      pending, committed;
+        bool                        has_pending, has_committed, pending_ok;
+        int                         rank;
+        size_t                      ncommitted;
+
+        // the epoch all ranks took, which commits at the next agreement,
+        // the committed epochs whose files go once the manifest names a
+        // later one, the last epoch all ranks took, the epoch rank 0 named
+        // in the manifest and the agreement in flight
+        checkpoint::manifest_t                  candidate;
+        bool                                    has_candidate, candidate_ok;
+        std::vector<checkpoint::manifest_t>     superseded;
+        long long                               agreed, named;
+        MPI_Request                             agree_req;
+        long long                               agree_vals[7];
+        size_t                                  agree_epoch;
+        int                                     comm_rank, comm_size;
+
+        // write the snapshot to a file
+        void write_file(std::string fname);
+
+        // handle the outcome of an agreement
+        void finish_agreement();
+
+        // remove the files of epochs before some epoch, or the files of
+        // an epoch, which are dealt out over the ranks since an epoch
+        // restarted from may have been written by more ranks
+        void prune(long long epoch);
+        void remove_files(const checkpoint::manifest_t& epoch);
+
+    };
+
+}// end namespace pso
+
+#endif /* checkpoint_hpp */
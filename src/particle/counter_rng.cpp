@@ -0,0 +1,197 @@
+//
+//  counter_rng.cpp
+//  async_pso
+//
+
+#include "counter_rng.hpp"
+#include "update_kernels.hpp"
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define APSO_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+namespace pso {
+
+    // Philox4x32 constants
+    static const uint32_t philox_m0 = 0xD2511F53u;
+    static const uint32_t philox_m1 = 0xCD9E8D57u;
+    static const uint32_t philox_w0 = 0x9E3779B9u;
+    static const uint32_t philox_w1 = 0xBB67AE85u;
+
+    // exponent bits of 1.0, used to map 52 random mantissa
+    // bits onto [1,2) before shifting the result down to [0,1)
+    static const uint64_t one_bits = 0x3FF0000000000000ull;
+
+    // forward declaration of the batch generator selection
+    static counter_rng::batch_fn select_batch_fn();
+
+    // ctor/dtor
+    counter_rng::counter_rng(uint64_t seed):batch(select_batch_fn()) {
+        set_seed(seed);
+    }
+
+    // set/get the seed
+    void counter_rng::set_seed(uint64_t seed) {
+        key[0] = static_cast<uint32_t>(seed);
+        key[1] = static_cast<uint32_t>(seed >> 32);
+    }
+    uint64_t counter_rng::get_seed() const {
+        return (static_cast<uint64_t>(key[1]) << 32) | key[0];
+    }
+
+    // raw Philox4x32-10 bijection
+    void counter_rng::philox(const uint32_t ctr[4], const uint32_t key_[2], uint32_t out[4]) {
+        uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+        uint32_t k0 = key_[0], k1 = key_[1];
+        for(int r = 0; r < 10; ++r){
+            uint64_t p0 = static_cast<uint64_t>(philox_m0) * c0;
+            uint64_t p1 = static_cast<uint64_t>(philox_m1) * c2;
+            uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+            uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+            c0 = n0; c1 = static_cast<uint32_t>(p1);
+            c2 = n2; c3 = static_cast<uint32_t>(p0);
+            k0 += philox_w0; k1 += philox_w1;
+        }
+        out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+    }
+
+    // number of philox blocks generated per batch. A batch gives
+    // 2*batch_lanes doubles: the first batch_lanes come from the
+    // upper halves of the blocks and the rest from the lower halves,
+    // which keeps the output identical across instruction sets.
+    static const size_t batch_lanes = 8;
+
+    // map 64 random bits onto [0,1) using the top 52 bits
+    static inline double to_unit(uint64_t bits) {
+        bits = (bits >> 12) | one_bits;
+        double u;
+        std::memcpy(&u, &bits, sizeof(u));
+        return u - 1.0;
+    }
+
+    // generate a single batch of 2*batch_lanes uniforms
+    static void scalar_batch(const uint32_t ctr[3], uint32_t c3_0, const uint32_t key[2], double* out) {
+        uint32_t c[4], rnd[4];
+        c[0] = ctr[0]; c[1] = ctr[1]; c[2] = ctr[2];
+        for(size_t l = 0; l < batch_lanes; ++l){
+            c[3] = c3_0 + static_cast<uint32_t>(l);
+            counter_rng::philox(c, key, rnd);
+            out[l]              = to_unit((static_cast<uint64_t>(rnd[0]) << 32) | rnd[1]);
+            out[batch_lanes+l]  = to_unit((static_cast<uint64_t>(rnd[2]) << 32) | rnd[3]);
+        }
+    }
+
+#ifdef APSO_X86_DISPATCH
+
+    // 32-bit philox words are kept in the low half of 64-bit lanes
+    // so _mm256_mul_epu32 gives the full 64-bit products
+    __attribute__((target("avx2")))
+    static void avx2_batch(const uint32_t ctr[3], uint32_t c3_0, const uint32_t key[2], double* out) {
+        const __m256i lo32  = _mm256_set1_epi64x(0xFFFFFFFFll);
+        const __m256i m0    = _mm256_set1_epi64x(philox_m0);
+        const __m256i m1    = _mm256_set1_epi64x(philox_m1);
+        const __m256i one   = _mm256_set1_epi64x(static_cast<long long>(one_bits));
+        const __m256d done  = _mm256_set1_pd(1.0);
+
+        for(size_t h = 0; h < batch_lanes; h += 4){
+            __m256i c0 = _mm256_set1_epi64x(ctr[0]);
+            __m256i c1 = _mm256_set1_epi64x(ctr[1]);
+            __m256i c2 = _mm256_set1_epi64x(ctr[2]);
+            __m256i c3 = _mm256_set_epi64x(c3_0 + h + 3, c3_0 + h + 2, c3_0 + h + 1, c3_0 + h);
+            uint32_t k0 = key[0], k1 = key[1];
+            for(int r = 0; r < 10; ++r){
+                __m256i p0 = _mm256_mul_epu32(m0, c0);
+                __m256i p1 = _mm256_mul_epu32(m1, c2);
+                __m256i n0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), c1),
+                                              _mm256_set1_epi64x(k0));
+                __m256i n2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), c3),
+                                              _mm256_set1_epi64x(k1));
+                c0 = n0; c1 = _mm256_and_si256(p1, lo32);
+                c2 = n2; c3 = _mm256_and_si256(p0, lo32);
+                k0 += philox_w0; k1 += philox_w1;
+            }
+
+            // convert the random bits into doubles
+            __m256i a = _mm256_or_si256(_mm256_slli_epi64(c0, 32), c1);
+            __m256i b = _mm256_or_si256(_mm256_slli_epi64(c2, 32), c3);
+            a = _mm256_or_si256(_mm256_srli_epi64(a, 12), one);
+            b = _mm256_or_si256(_mm256_srli_epi64(b, 12), one);
+            _mm256_storeu_pd(out + h, _mm256_sub_pd(_mm256_castsi256_pd(a), done));
+            _mm256_storeu_pd(out + batch_lanes + h, _mm256_sub_pd(_mm256_castsi256_pd(b), done));
+        }
+    }
+
+    __attribute__((target("avx512f")))
+    static void avx512_batch(const uint32_t ctr[3], uint32_t c3_0, const uint32_t key[2], double* out) {
+        const __m512i lo32  = _mm512_set1_epi64(0xFFFFFFFFll);
+        const __m512i m0    = _mm512_set1_epi64(philox_m0);
+        const __m512i m1    = _mm512_set1_epi64(philox_m1);
+        const __m512i one   = _mm512_set1_epi64(static_cast<long long>(one_bits));
+        const __m512d done  = _mm512_set1_pd(1.0);
+
+        __m512i c0 = _mm512_set1_epi64(ctr[0]);
+        __m512i c1 = _mm512_set1_epi64(ctr[1]);
+        __m512i c2 = _mm512_set1_epi64(ctr[2]);
+        __m512i c3 = _mm512_add_epi64(_mm512_set1_epi64(c3_0),
+                                      _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0));
+        uint32_t k0 = key[0], k1 = key[1];
+        for(int r = 0; r < 10; ++r){
+            __m512i p0 = _mm512_mul_epu32(m0, c0);
+            __m512i p1 = _mm512_mul_epu32(m1, c2);
+            __m512i n0 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p1, 32), c1),
+                                          _mm512_set1_epi64(k0));
+            __m512i n2 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p0, 32), c3),
+                                          _mm512_set1_epi64(k1));
+            c0 = n0; c1 = _mm512_and_si512(p1, lo32);
+            c2 = n2; c3 = _mm512_and_si512(p0, lo32);
+            k0 += philox_w0; k1 += philox_w1;
+        }
+
+        // convert the random bits into doubles
+        __m512i a = _mm512_or_si512(_mm512_slli_epi64(c0, 32), c1);
+        __m512i b = _mm512_or_si512(_mm512_slli_epi64(c2, 32), c3);
+        a = _mm512_or_si512(_mm512_srli_epi64(a, 12), one);
+        b = _mm512_or_si512(_mm512_srli_epi64(b, 12), one);
+        _mm512_storeu_pd(out, _mm512_sub_pd(_mm512_castsi512_pd(a), done));
+        _mm512_storeu_pd(out + batch_lanes, _mm512_sub_pd(_mm512_castsi512_pd(b), done));
+    }
+
+#endif
+
+    // pick the batch generator for the current cpu
+    static counter_rng::batch_fn select_batch_fn() {
+        switch( kernels::best_supported_isa() ){
+#ifdef APSO_X86_DISPATCH
+            case kernels::AVX2:     return &avx2_batch;
+            case kernels::AVX512:   return &avx512_batch;
+#endif
+            default:                return &scalar_batch;
+        }
+    }
+
+    // fill n uniform samples in [0,1) for some stream at some step
+    void counter_rng::fill(uint64_t stream, uint64_t step, uint32_t tag, double* out, size_t n) const {
+        const size_t per_batch = 2*batch_lanes;
+        uint32_t ctr[3];
+        ctr[0] = static_cast<uint32_t>(stream);
+        ctr[1] = static_cast<uint32_t>(stream >> 32);
+        ctr[2] = static_cast<uint32_t>(step);
+        const uint32_t hi = tag << 28;
+
+        // generate full batches straight into the output
+        size_t i = 0, j = 0;
+        for(; i + per_batch <= n; i += per_batch, j += batch_lanes){
+            batch(ctr, hi | static_cast<uint32_t>(j), key, out + i);
+        }
+
+        // generate the remainder into a temporary
+        if( i < n ){
+            double tmp[2*batch_lanes];
+            batch(ctr, hi | static_cast<uint32_t>(j), key, tmp);
+            std::memcpy(out + i, tmp, (n - i)*sizeof(double));
+        }
+    }
+
+}// end namespace pso
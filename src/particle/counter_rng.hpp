@@ -0,0 +1,60 @@
+//
+//  counter_rng.hpp
+//  async_pso
+//
+
+#ifndef counter_rng_hpp
+#define counter_rng_hpp
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pso {
+
+    /*
+     Counter-based random number generator built on the
+     Philox4x32-10 bijection (Salmon et al., SC'11). Every
+     block of uniforms is a pure function of the seed and a
+     (stream, step, tag, block) counter, so the generator holds
+     no mutable state: any thread can fill any range and the
+     samples for a given (rank, particle, iteration) are always
+     the same no matter how the work is split up.
+     */
+    class counter_rng {
+    public:
+
+        // tags to separate independent uses of the same stream/step
+        enum tag_t: uint32_t {
+            Init = 0,
+            Local,
+            Global,
+            User
+        };
+
+        // ctor/dtor
+        counter_rng(uint64_t seed = 0);
+        ~counter_rng() = default;
+
+        // set/get the seed
+        void set_seed(uint64_t seed);
+        uint64_t get_seed() const;
+
+        // fill n uniform samples in [0,1) for some stream at some step.
+        // The step is used modulo 2^32 and n must be below 2^29.
+        void fill(uint64_t stream, uint64_t step, uint32_t tag, double* out, size_t n) const;
+
+        // raw Philox4x32-10 bijection
+        static void philox(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]);
+
+        // signature of a (possibly vectorized) batch generator
+        using batch_fn = void(*)(const uint32_t ctr[3], uint32_t c3_0, const uint32_t key[2], double* out);
+
+    private:
+        uint32_t key[2];
+        batch_fn batch;
+
+    };
+
+}// end namespace pso
+
+#endif /* counter_rng_hpp */
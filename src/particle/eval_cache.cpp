@@ -0,0 +1,178 @@
+//
+//  eval_cache.cpp
+//  async_pso
+//
+
+#include "eval_cache.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace pso {
+
+    // ctor/dtor
+    eval_cache::eval_cache(size_t capacity_, double quantum_):capacity(capacity_), quantum(0.0), share(false)
+    {
+        set_quantum(quantum_);
+        stats.hits = stats.misses = stats.inserts = stats.shared = stats.evictions = 0;
+    }
+
+    // set the max number of entries and the quantum
+    void eval_cache::set_capacity(size_t capacity_) {
+        std::lock_guard<std::mutex> lk(lock);
+        capacity = capacity_;
+        while( entries.size() > capacity ){
+            table.erase(entries.back().hash);
+            entries.pop_back();
+            ++stats.evictions;
+        }
+    }
+    void eval_cache::set_quantum(double quantum_) {
+        std::lock_guard<std::mutex> lk(lock);
+        quantum = quantum_ > 0.0 ? quantum_ : 0.0;
+        entries.clear();
+        table.clear();
+    }
+    bool eval_cache::enabled() const {
+        return capacity > 0;
+    }
+
+    // set whether values get queued up for sharing
+    void eval_cache::set_sharing(bool share_) {
+        std::lock_guard<std::mutex> lk(lock);
+        share = share_;
+        if( !share ){ recent.clear(); }
+    }
+
+    // look up the value for a position
+    bool eval_cache::lookup(const double* x, size_t dim, double& fval) {
+        const uint64_t h = hash(x, dim);
+        std::lock_guard<std::mutex> lk(lock);
+        auto it = table.find(h);
+        if( it == table.end() || !matches(*it->second, x, dim) ){
+            ++stats.misses;
+            return false;
+        }
+
+        // move the entry to the front of the LRU order
+        entries.splice(entries.begin(), entries, it->second);
+        fval = it->second->fval;
+        ++stats.hits;
+        return true;
+    }
+
+    // store the value of a position computed on this rank
+    void eval_cache::insert(const double* x, size_t dim, double fval) {
+        if( !enabled() ){ return; }
+        std::lock_guard<std::mutex> lk(lock);
+        store(x, dim, fval);
+        ++stats.inserts;
+        if( !share ){ return; }
+        recent.insert(recent.end(), x, x + dim);
+        recent.push_back(fval);
+
+        // only keep as many recent values as fit in the cache,
+        // dropping the oldest rows
+        const size_t row = dim + 1;
+        while( recent.size() > capacity*row ){
+            recent.erase(recent.begin(), recent.begin() + row);
+        }
+    }
+
+    // store a value received from another rank
+    void eval_cache::insert_shared(const double* x, size_t dim, double fval) {
+        if( !enabled() ){ return; }
+        std::lock_guard<std::mutex> lk(lock);
+        store(x, dim, fval);
+        ++stats.shared;
+    }
+
+    // take up to max_entries of the values inserted since the last call
+    size_t eval_cache::take_recent(std::vector<double>& out, size_t dim, size_t max_entries) {
+        std::lock_guard<std::mutex> lk(lock);
+        const size_t row = dim + 1;
+        const size_t count = std::min(recent.size() / row, max_entries);
+
+        // hand out the newest values and forget the rest
+        out.assign(recent.end() - count*row, recent.end());
+        recent.clear();
+        return count;
+    }
+
+    // drop all the entries
+    void eval_cache::clear() {
+        std::lock_guard<std::mutex> lk(lock);
+        entries.clear();
+        table.clear();
+        recent.clear();
+    }
+
+    // get the counters
+    size_t eval_cache::size() const {
+        std::lock_guard<std::mutex> lk(lock);
+        return entries.size();
+    }
+    cache_stats eval_cache::get_stats() const {
+        std::lock_guard<std::mutex> lk(lock);
+        return stats;
+    }
+    double eval_cache::hit_rate() const {
+        std::lock_guard<std::mutex> lk(lock);
+        const size_t total = stats.hits + stats.misses;
+        return total ? static_cast<double>(stats.hits) / total : 0.0;
+    }
+
+    // quantize a coordinate, where without a quantum the bits
+    // are the key, with -0.0 folded into 0.0
+    int64_t eval_cache::quantize(double x) const {
+        if( quantum > 0.0 ){ return static_cast<int64_t>(std::llround(x / quantum)); }
+        if( x == 0.0 ){ x = 0.0; }
+        int64_t bits = 0;
+        std::memcpy(&bits, &x, sizeof(bits));
+        return bits;
+    }
+
+    // FNV-1a style hash over the quantized coordinates
+    uint64_t eval_cache::hash(const double* x, size_t dim) const {
+        uint64_t h = 1469598103934665603ull;
+        for(size_t i = 0; i < dim; ++i){
+            h ^= static_cast<uint64_t>(quantize(x[i]));
+            h *= 1099511628211ull;
+            h ^= h >> 29;
+        }
+        return h;
+    }
+    bool eval_cache::matches(const entry_t& entry, const double* x, size_t dim) const {
+        if( entry.key.size() != dim ){ return false; }
+        for(size_t i = 0; i < dim; ++i){
+            if( entry.key[i] != quantize(x[i]) ){ return false; }
+        }
+        return true;
+    }
+
+    // store a value, replacing any entry with the same hash
+    void eval_cache::store(const double* x, size_t dim, double fval) {
+        const uint64_t h = hash(x, dim);
+        auto it = table.find(h);
+        if( it != table.end() ){
+            entries.erase(it->second);
+            table.erase(it);
+        }
+
+        entry_t entry;
+        entry.hash = h;
+        entry.fval = fval;
+        entry.key.resize(dim);
+        for(size_t i = 0; i < dim; ++i){ entry.key[i] = quantize(x[i]); }
+        entries.push_front(std::move(entry));
+        table[h] = entries.begin();
+
+        // drop the least recently used entries
+        while( entries.size() > capacity ){
+            table.erase(entries.back().hash);
+            entries.pop_back();
+            ++stats.evictions;
+        }
+    }
+
+}// end namespace pso
@@ -0,0 +1,117 @@
+//
+//  eval_cache.hpp
+//  async_pso
+//
+
+#ifndef eval_cache_hpp
+#define eval_cache_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace pso {
+
+    // counters of a cache
+    struct cache_stats {
+        size_t hits;        // lookups that found a value
+        size_t misses;      // lookups that did not
+        size_t inserts;     // values computed on this rank and stored
+        size_t shared;      // values received from other ranks and stored
+        size_t evictions;   // values dropped to stay within capacity
+    };
+
+    // per thread scratch space for evaluations through a cache
+    struct cache_scratch {
+        std::vector<double> x, f;
+        std::vector<size_t> idx;
+    };
+
+    /*
+     Bounded LRU cache of objective values keyed by quantized
+     positions. With a quantum q > 0, positions whose coordinates
+     all round to the same multiple of q share an entry, so a value
+     may come from a point up to q/2 away in each coordinate. With
+     q = 0 only bitwise identical positions match, which is what
+     particles clamped onto the same face of the domain end up at.
+     All methods are safe to call from several threads at once.
+     */
+    class eval_cache {
+    public:
+
+        // ctor/dtor, where a capacity of 0 turns the cache off
+        eval_cache(size_t capacity = 0, double quantum = 0.0);
+        ~eval_cache() = default;
+
+        // set the max number of entries and the quantum
+        void set_capacity(size_t capacity);
+        void set_quantum(double quantum);
+        bool enabled() const;
+
+        // set whether the values inserted on this rank are queued up
+        // for take_recent, which only pays off when they get shared
+        void set_sharing(bool share);
+
+        // look up the value for a position, returning true on a hit
+        bool lookup(const double* x, size_t dim, double& fval);
+
+        // store the value of a position computed on this rank, which
+        // is also queued up for sharing with other ranks if that is on
+        void insert(const double* x, size_t dim, double fval);
+
+        // store a value received from another rank
+        void insert_shared(const double* x, size_t dim, double fval);
+
+        // take up to max_entries of the values inserted since the last
+        // call, as rows of [x_1, ..., x_dim, fval], returning the count
+        size_t take_recent(std::vector<double>& entries, size_t dim, size_t max_entries);
+
+        // drop all the entries
+        void clear();
+
+        // get the counters and the fraction of lookups that hit
+        size_t size() const;
+        cache_stats get_stats() const;
+        double hit_rate() const;
+
+    private:
+
+        // cache entry, keeping the quantized position to
+        // tell apart positions with the same hash
+        struct entry_t {
+            uint64_t                hash;
+            std::vector<int64_t>    key;
+            double                  fval;
+        };
+        using list_t = std::list<entry_t>;
+
+        // settings
+        size_t  capacity;
+        double  quantum;
+        bool    share;
+
+        // entries in LRU order, most recent first, and the values to
+        // share as rows of [x, fval], oldest first
+        list_t                                          entries;
+        std::unordered_map<uint64_t, list_t::iterator>  table;
+        std::deque<double>                              recent;
+        cache_stats                                     stats;
+        mutable std::mutex                              lock;
+
+        // quantize a coordinate and hash a position
+        int64_t quantize(double x) const;
+        uint64_t hash(const double* x, size_t dim) const;
+        bool matches(const entry_t& entry, const double* x, size_t dim) const;
+
+        // store a value, with the lock held
+        void store(const double* x, size_t dim, double fval);
+
+    };
+
+}// end namespace pso
+
+#endif /* eval_cache_hpp */
@@ -0,0 +1,128 @@
+//
+//  objective_eval.hpp
+//  async_pso
+//
+
+#ifndef objective_eval_hpp
+#define objective_eval_hpp
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "particle_block.hpp"
+#include "eval_cache.hpp"
+
+namespace pso {
+
+    /*
+     Trait to detect an objective that can evaluate many
+     points with one call. Such an objective provides
+
+        void evaluate_batch(const double* x, size_t num, size_t dim,
+                            size_t ld, double* fvals);
+
+     where row k of the num x ld row-major matrix x holds the
+     k-th point (first dim entries) and fvals[k] receives its
+     objective value. The usual single point operator() is
+     still required for everything else.
+     */
+    template<typename func_type, typename = void>
+    struct has_batch_eval : std::false_type {};
+
+    template<typename func_type>
+    struct has_batch_eval<func_type,
+        decltype(std::declval<func_type&>().evaluate_batch(std::declval<const double*>(),
+                                                           std::declval<size_t>(),
+                                                           std::declval<size_t>(),
+                                                           std::declval<size_t>(),
+                                                           std::declval<double*>()), void())>
+        : std::true_type {};
+
+    namespace detail {
+
+        // batch evaluation directly on the point matrix
+        template<typename func_type>
+        void evaluate_points(func_type& f, const double* x, size_t num, size_t dim, size_t ld,
+                             double* fvals, std::vector<double>&, std::true_type)
+        {
+            f.evaluate_batch(x, num, dim, ld, fvals);
+        }
+
+        // point by point evaluation through a scratch vector
+        template<typename func_type>
+        void evaluate_points(func_type& f, const double* x, size_t num, size_t dim, size_t ld,
+                             double* fvals, std::vector<double>& xeval, std::false_type)
+        {
+            for(size_t k = 0; k < num; ++k){
+                const double* xk = x + k*ld;
+                xeval.assign(xk, xk + dim);
+                fvals[k] = f(xeval);
+            }
+        }
+
+    }// end namespace detail
+
+    // evaluate the objective for the num points stored in the rows of
+    // the row-major matrix x with leading dimension ld, writing the
+    // values into fvals, using the batch call whenever possible
+    template<typename func_type>
+    void evaluate_points(func_type& f, const double* x, size_t num, size_t dim, size_t ld,
+                         double* fvals, std::vector<double>& xeval)
+    {
+        if( num == 0 ){ return; }
+        detail::evaluate_points(f, x, num, dim, ld, fvals, xeval,
+                                has_batch_eval<func_type>());
+    }
+
+    // evaluate the objective for particles [first, last) of some
+    // block, writing the values into fvals[0 .. last-first), using
+    // the batch call whenever the objective provides one
+    template<typename func_type>
+    void evaluate_particles(func_type& f, const particle_block& block,
+                            size_t first, size_t last,
+                            double* fvals, std::vector<double>& xeval)
+    {
+        if( first >= last ){ return; }
+        evaluate_points(f, block.position(first), last - first,
+                        block.num_dims(), block.stride(), fvals, xeval);
+    }
+
+    // evaluate particles [first, last) of some block through a cache,
+    // where only the positions missing from the cache are passed on to
+    // the objective, as a single batch if it supports that
+    template<typename func_type>
+    void evaluate_particles(func_type& f, eval_cache& cache, cache_scratch& scratch,
+                            const particle_block& block, size_t first, size_t last,
+                            double* fvals, std::vector<double>& xeval)
+    {
+        if( !cache.enabled() ){
+            evaluate_particles(f, block, first, last, fvals, xeval);
+            return;
+        }
+        
+        // gather up the misses
+        const size_t dim = block.num_dims();
+        scratch.idx.clear();
+        scratch.x.clear();
+        for(size_t k = first; k < last; ++k){
+            const double* x = block.position(k);
+            if( !cache.lookup(x, dim, fvals[k-first]) ){
+                scratch.idx.push_back(k-first);
+                scratch.x.insert(scratch.x.end(), x, x + dim);
+            }
+        }
+        
+        // evaluate them and store the values
+        const size_t nmiss = scratch.idx.size();
+        scratch.f.resize(nmiss);
+        evaluate_points(f, scratch.x.data(), nmiss, dim, dim, scratch.f.data(), xeval);
+        for(size_t j = 0; j < nmiss; ++j){
+            fvals[scratch.idx[j]] = scratch.f[j];
+            cache.insert(&scratch.x[j*dim], dim, scratch.f[j]);
+        }
+    }
+
+}// end namespace pso
+
+#endif /* objective_eval_hpp */
@@ -9,55 +9,75 @@
 #ifndef particle_hpp
 #define particle_hpp
 
+#include <cstddef>
+#include <memory>
 #include <random>
 #include <vector>
 
 namespace pso {
-    
+
+    // forward declaration of the storage and generator
+    class particle_block;
+    class counter_rng;
+
+    /*
+     Single particle whose state lives inside of a particle_block.
+     A particle built from a number of dims owns a one particle block,
+     while particle_block::operator[] hands out views into its rows.
+     The settings and set_num_dims act on the block the particle
+     lives in, which for a view is the whole block, while views are
+     initialized through their block rather than through initialize
+     */
     class particle {
     public:
-        
+
         // ctor/dtor
         particle(int dim = 0);
-        ~particle() = default;
-        
+        particle(particle_block* block, size_t idx);
+        particle(const particle& p);
+        particle& operator=(const particle& p);
+        ~particle();
+
         // set number of dims for particle
         void set_num_dims(int dim);
+        size_t num_dims() const;
+
+        // set the settings of the particle's block
         void set_momentum(double omega);
         void set_particle_weights(double phi_local, double phi_global);
-        
-        // initialize
+
+        // initialize a standalone particle, seeding its random stream from gen
         void initialize(std::mt19937& gen,
                         const std::vector<double>& lb,
                         const std::vector<double>& ub);
-        
+
         // update the particle state
         void update(const std::vector<double>& global_best);
-        
+
         // set the function value for the particle
         void set_function_value(double fval);
-        
+
         // get the current function value or state
         double get_current_val() const;
-        const std::vector<double>& get_current_position();
-        
+        const std::vector<double>& get_current_position() const;
+
         // get the current best states for this particle
         double get_best_val() const;
         const std::vector<double>& get_best_position() const;
-        
+
     private:
-        double func_val, w, phi_l, phi_g;
-        std::vector<double> p;
-        std::vector<double> v;
-        const std::vector<double> *lb;
-        const std::vector<double> *ub;
-        std::mt19937* gen;
-        
-        double best_val;
-        std::vector<double> best_p;
-        
+        particle_block* block;
+        size_t idx;
+
+        // storage and generator of a standalone particle
+        std::unique_ptr<particle_block> own;
+        std::shared_ptr<counter_rng>    rng;
+
+        // copies of the block rows handed out by the getters
+        mutable std::vector<double> pos, best_pos;
+
     };
-    
+
 }// end namespace pso
 
 #endif /* particle_hpp */
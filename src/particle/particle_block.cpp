@@ -0,0 +1,312 @@
+//
+//  particle_block.cpp
+//  async_pso
+//
+
+#include "particle_block.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace pso {
+
+    // ctor/dtor
+    particle_block::particle_block(size_t num_particles, size_t dim):nparticles(0), ndim(0), ld(0),
+    w(0.9), phi_l(0.7), phi_g(0.5), rng(nullptr)
+    {
+        set_update_isa(kernels::Auto);
+        resize(num_particles, dim);
+    }
+
+    // set number of particles and dims for the block
+    void particle_block::resize(size_t num_particles, size_t dim){
+        const size_t per_line = alignment / sizeof(double);
+        nparticles  = num_particles;
+        ndim        = dim;
+        ld          = ((dim + per_line - 1) / per_line) * per_line;
+
+        // padding entries are kept at zero so whole rows
+        // can be processed without a remainder loop
+        pos.assign(nparticles * ld, 0.0);
+        vel.assign(nparticles * ld, 0.0);
+        best_pos.assign(nparticles * ld, 0.0);
+        fval.assign(nparticles, std::numeric_limits<double>::max());
+        best_val.assign(nparticles, std::numeric_limits<double>::max());
+        lb.assign(ld, 0.0);
+        ub.assign(ld, 0.0);
+        gbest.assign(ld, 0.0);
+        rl.assign(nparticles * ld, 0.0);
+        rg.assign(nparticles * ld, 0.0);
+        steps.assign(nparticles, 0);
+        ids.resize(nparticles);
+        set_stream_ids(0);
+    }
+
+    void particle_block::set_momentum(double omega) {
+        w = omega;
+    }
+    void particle_block::set_particle_weights(double phi_local, double phi_global){
+        phi_l = phi_local;
+        phi_g = phi_global;
+    }
+    
+    // pick the instruction set used by the update kernel
+    void particle_block::set_update_isa(kernels::isa_t isa_) {
+        isa     = kernels::is_supported(isa_) && isa_ != kernels::Auto ? isa_ : kernels::best_supported_isa();
+        kernel  = kernels::get_update_kernel(isa);
+    }
+    kernels::isa_t particle_block::get_update_isa() const {
+        return isa;
+    }
+
+    // set the random streams used by the particles
+    void particle_block::set_stream_ids(uint64_t first_id) {
+        for(size_t k = 0; k < nparticles; ++k){
+            ids[k] = first_id + k;
+        }
+    }
+    uint64_t particle_block::get_stream_id(size_t idx) const {
+        return ids[idx];
+    }
+    uint64_t particle_block::get_step(size_t idx) const {
+        return steps[idx];
+    }
+
+    // initialize
+    void particle_block::initialize(const counter_rng& rng_,
+                                    const std::vector<double>& lb_,
+                                    const std::vector<double>& ub_)
+    {
+        // set the references needed
+        rng = &rng_;
+        for(size_t i = 0; i < ndim; ++i){
+            lb[i] = lb_[i];
+            ub[i] = ub_[i];
+        }
+
+        // loop and initialize the positions and velocities
+        for(size_t k = 0; k < nparticles; ++k){
+            double* p   = position(k);
+            double* v   = velocity(k);
+            double* bp  = best_position(k);
+
+            // draw the samples into the update buffers
+            double* s   = &rl[k*ld];
+            double* t   = &rg[k*ld];
+            rng->fill(ids[k], 0, counter_rng::Init, s, ndim);
+            rng->fill(ids[k], 1, counter_rng::Init, t, ndim);
+
+            for(size_t i = 0; i < ndim; ++i){
+                double del  = std::abs(lb_[i] - ub_[i]);
+                p[i]        = lb_[i]*s[i] + ub_[i]*(1-s[i]);
+                bp[i]       = p[i];
+                v[i]        = -del*t[i] + del*(1-t[i]);
+            }
+            fval[k]     = std::numeric_limits<double>::max();
+            best_val[k] = std::numeric_limits<double>::max();
+            steps[k]    = 0;
+        }
+
+    }
+
+    // update the particle states
+    void particle_block::update(size_t idx, const std::vector<double>& global_best)
+    {
+        update(idx, idx+1, global_best);
+    }
+    void particle_block::update(size_t first, size_t last, const std::vector<double>& global_best)
+    {
+        if( set_global_best(global_best) ){ update_range(first, last); }
+    }
+    void particle_block::update(const std::vector<double>& global_best)
+    {
+        update(0, nparticles, global_best);
+    }
+    bool particle_block::set_global_best(const std::vector<double>& global_best)
+    {
+        // nothing to do without particles, and nothing to go
+        // toward until there is a full global best estimate
+        if( nparticles == 0 || global_best.size() < ndim ){ return false; }
+        
+        // copy the global best into the padded buffer
+        for(size_t i = 0; i < ndim; ++i){
+            gbest[i] = global_best[i];
+        }
+        return true;
+    }
+    void particle_block::update_range(size_t first, size_t last)
+    {
+        update_range(first, last, gbest.data());
+    }
+    void particle_block::update_range(size_t first, size_t last, const double* global_best)
+    {
+        if( first >= last ){ return; }
+        
+        // draw the uniform samples for the particles in one
+        // pass, each from its own (stream, step) counter
+        for(size_t k = first; k < last; ++k){
+            rng->fill(ids[k], steps[k], counter_rng::Local, &rl[k*ld], ndim);
+            rng->fill(ids[k], steps[k], counter_rng::Global, &rg[k*ld], ndim);
+            ++steps[k];
+        }
+        
+        // update the particles with the vectorized kernel
+        kernels::update_args args;
+        args.num        = last - first;
+        args.ld         = ld;
+        args.pos        = position(first);
+        args.vel        = velocity(first);
+        args.best_pos   = best_position(first);
+        args.gbest      = global_best;
+        args.lb         = lb.data();
+        args.ub         = ub.data();
+        args.rl         = &rl[first*ld];
+        args.rg         = &rg[first*ld];
+        args.w          = w;
+        args.phi_l      = phi_l;
+        args.phi_g      = phi_g;
+        kernel(args);
+    }
+
+    // set the function value for some particle
+    void particle_block::set_function_value(size_t idx, double fval_) {
+        fval[idx] = fval_;
+
+        // update personal best, if necessary
+        if( fval_ < best_val[idx] ){
+            best_val[idx] = fval_;
+            const double* p = position(idx);
+            double* bp      = best_position(idx);
+            for(size_t i = 0; i < ndim; ++i){
+                bp[i] = p[i];
+            }
+        }
+    }
+
+    // get the sizes of the block
+    size_t particle_block::size() const {
+        return nparticles;
+    }
+    size_t particle_block::num_dims() const {
+        return ndim;
+    }
+    size_t particle_block::stride() const {
+        return ld;
+    }
+
+    // get the current function value or state
+    double particle_block::get_current_val(size_t idx) const {
+        return fval[idx];
+    }
+    double* particle_block::position(size_t idx) {
+        return pos.data() + idx*ld;
+    }
+    const double* particle_block::position(size_t idx) const {
+        return pos.data() + idx*ld;
+    }
+    double* particle_block::velocity(size_t idx) {
+        return vel.data() + idx*ld;
+    }
+    const double* particle_block::velocity(size_t idx) const {
+        return vel.data() + idx*ld;
+    }
+
+    // get the current best states for some particle
+    double particle_block::get_best_val(size_t idx) const {
+        return best_val[idx];
+    }
+    double* particle_block::best_position(size_t idx) {
+        return best_pos.data() + idx*ld;
+    }
+    const double* particle_block::best_position(size_t idx) const {
+        return best_pos.data() + idx*ld;
+    }
+
+    // get a lightweight view of some particle
+    particle particle_block::operator[](size_t idx) {
+        return particle(this, idx);
+    }
+    
+    // get the bounding box of the current positions
+    void particle_block::position_bounds(std::vector<double>& lo, std::vector<double>& hi) const {
+        lo.assign(ndim, std::numeric_limits<double>::max());
+        hi.assign(ndim, std::numeric_limits<double>::lowest());
+        for(size_t k = 0; k < nparticles; ++k){
+            const double* x = position(k);
+            for(size_t i = 0; i < ndim; ++i){
+                lo[i] = std::min(lo[i], x[i]);
+                hi[i] = std::max(hi[i], x[i]);
+            }
+        }
+    }
+    
+    // serialize a particle as [pos, vel, best_pos, fval, best_val, id, step]
+    size_t particle_block::packed_bytes() const {
+        return (3*ndim + 2)*sizeof(double) + 2*sizeof(uint64_t);
+    }
+    size_t particle_block::pack(size_t idx, unsigned char* buffer) const {
+        const size_t row = ndim*sizeof(double);
+        unsigned char* b = buffer;
+        std::memcpy(b, position(idx), row);             b += row;
+        std::memcpy(b, velocity(idx), row);             b += row;
+        std::memcpy(b, best_position(idx), row);        b += row;
+        std::memcpy(b, &fval[idx], sizeof(double));     b += sizeof(double);
+        std::memcpy(b, &best_val[idx], sizeof(double)); b += sizeof(double);
+        std::memcpy(b, &ids[idx], sizeof(uint64_t));    b += sizeof(uint64_t);
+        std::memcpy(b, &steps[idx], sizeof(uint64_t));  b += sizeof(uint64_t);
+        return static_cast<size_t>(b - buffer);
+    }
+    
+    // add a packed particle to the end of the block
+    size_t particle_block::unpack(const unsigned char* buffer) {
+        const size_t idx = nparticles;
+        resize_particles(nparticles + 1);
+        
+        const size_t row = ndim*sizeof(double);
+        const unsigned char* b = buffer;
+        std::memcpy(position(idx), b, row);             b += row;
+        std::memcpy(velocity(idx), b, row);             b += row;
+        std::memcpy(best_position(idx), b, row);        b += row;
+        std::memcpy(&fval[idx], b, sizeof(double));     b += sizeof(double);
+        std::memcpy(&best_val[idx], b, sizeof(double)); b += sizeof(double);
+        std::memcpy(&ids[idx], b, sizeof(uint64_t));    b += sizeof(uint64_t);
+        std::memcpy(&steps[idx], b, sizeof(uint64_t));
+        return idx;
+    }
+    
+    // remove a particle by moving the last particle into its place
+    void particle_block::remove(size_t idx) {
+        const size_t last = nparticles - 1;
+        if( idx != last ){
+            std::memcpy(position(idx), position(last), ld*sizeof(double));
+            std::memcpy(velocity(idx), velocity(last), ld*sizeof(double));
+            std::memcpy(best_position(idx), best_position(last), ld*sizeof(double));
+            fval[idx]       = fval[last];
+            best_val[idx]   = best_val[last];
+            ids[idx]        = ids[last];
+            steps[idx]      = steps[last];
+        }
+        resize_particles(last);
+    }
+    
+    // remove all the particles, keeping the dims and settings
+    void particle_block::clear() {
+        resize_particles(0);
+    }
+    
+    // resize the per particle storage, keeping existing particles
+    void particle_block::resize_particles(size_t num_particles) {
+        nparticles = num_particles;
+        pos.resize(nparticles * ld, 0.0);
+        vel.resize(nparticles * ld, 0.0);
+        best_pos.resize(nparticles * ld, 0.0);
+        fval.resize(nparticles, std::numeric_limits<double>::max());
+        best_val.resize(nparticles, std::numeric_limits<double>::max());
+        rl.resize(nparticles * ld, 0.0);
+        rg.resize(nparticles * ld, 0.0);
+        ids.resize(nparticles, 0);
+        steps.resize(nparticles, 0);
+    }
+
+}// end namespace pso
@@ -0,0 +1,155 @@
+//
+//  particle_block.hpp
+//  async_pso
+//
+
+#ifndef particle_block_hpp
+#define particle_block_hpp
+
+#include <cstdint>
+#include <vector>
+#include "aligned_allocator.hpp"
+#include "counter_rng.hpp"
+#include "particle.hpp"
+#include "update_kernels.hpp"
+
+namespace pso {
+
+    /*
+     Structure-of-arrays storage for all the particles
+     of a swarm partition. Positions, velocities and personal
+     bests are each stored as a single row-major matrix where
+     every row (particle) starts on a cache line boundary.
+     */
+    class particle_block {
+    public:
+
+        // number of bytes each particle row is aligned to
+        static constexpr size_t alignment = 64;
+
+        // ctor/dtor
+        particle_block(size_t num_particles = 0, size_t dim = 0);
+        ~particle_block() = default;
+
+        // set number of particles and dims for the block
+        void resize(size_t num_particles, size_t dim);
+        void set_momentum(double omega);
+        void set_particle_weights(double phi_local, double phi_global);
+        
+        // pick the instruction set used by the update kernel
+        void set_update_isa(kernels::isa_t isa);
+        kernels::isa_t get_update_isa() const;
+
+        // set the random streams used by the particles, where
+        // particle k uses stream first_id + k
+        void set_stream_ids(uint64_t first_id);
+        uint64_t get_stream_id(size_t idx) const;
+        uint64_t get_step(size_t idx) const;
+
+        // initialize
+        void initialize(const counter_rng& rng,
+                        const std::vector<double>& lb,
+                        const std::vector<double>& ub);
+
+        // update the particle states, either a single particle,
+        // a range of particles [first, last) or the whole block.
+        // Nothing is updated if global_best has fewer than ndim values
+        void update(size_t idx, const std::vector<double>& global_best);
+        void update(size_t first, size_t last, const std::vector<double>& global_best);
+        void update(const std::vector<double>& global_best);
+
+        // set the global best once and then update disjoint ranges,
+        // which is safe to do from several threads at once. Returns
+        // false and leaves the global best as it was when the block
+        // has no particles or global_best has fewer than ndim values
+        bool set_global_best(const std::vector<double>& global_best);
+        void update_range(size_t first, size_t last);
+
+        // update a range of particles with a caller owned global
+        // best that must be padded with zeros out to stride()
+        void update_range(size_t first, size_t last, const double* global_best);
+
+        // set the function value for some particle
+        void set_function_value(size_t idx, double fval);
+
+        // get the sizes of the block
+        size_t size() const;
+        size_t num_dims() const;
+        size_t stride() const;
+
+        // get the current function value or state
+        double get_current_val(size_t idx) const;
+        double* position(size_t idx);
+        const double* position(size_t idx) const;
+        double* velocity(size_t idx);
+        const double* velocity(size_t idx) const;
+
+        // get the current best states for some particle
+        double get_best_val(size_t idx) const;
+        double* best_position(size_t idx);
+        const double* best_position(size_t idx) const;
+
+        // get a lightweight view of some particle
+        particle operator[](size_t idx);
+        
+        // get the bounding box of the current positions,
+        // which is left empty (lo > hi) for an empty block
+        void position_bounds(std::vector<double>& lo, std::vector<double>& hi) const;
+        
+        // serialize a particle, including its random stream and step,
+        // so it can move to another block with the same dims
+        size_t packed_bytes() const;
+        size_t pack(size_t idx, unsigned char* buffer) const;
+        
+        // add a packed particle to the end of the block,
+        // returning its index
+        size_t unpack(const unsigned char* buffer);
+        
+        // remove a particle by moving the last particle into its place
+        void remove(size_t idx);
+        
+        // remove all the particles, keeping the dims and settings
+        void clear();
+
+    private:
+
+        // type alias for the aligned storage
+        using storage_t = util::aligned_vector<double, alignment>;
+
+        // sizes and coefficients
+        size_t nparticles, ndim, ld;
+        double w, phi_l, phi_g;
+
+        // particle state matrices
+        storage_t pos;
+        storage_t vel;
+        storage_t best_pos;
+        storage_t fval;
+        storage_t best_val;
+
+        // bounds and global best padded out to the row length
+        storage_t lb;
+        storage_t ub;
+        storage_t gbest;
+
+        // uniform samples used by the update kernel
+        storage_t rl;
+        storage_t rg;
+
+        // random stream and step counter of each particle
+        std::vector<uint64_t> ids;
+        std::vector<uint64_t> steps;
+
+        // update kernel and the generator
+        kernels::isa_t      isa;
+        kernels::update_fn  kernel;
+        const counter_rng*  rng;
+        
+        // resize the per particle storage, keeping existing particles
+        void resize_particles(size_t num_particles);
+
+    };
+
+}// end namespace pso
+
+#endif /* particle_block_hpp */
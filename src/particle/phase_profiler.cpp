@@ -0,0 +1,88 @@
+//
+//  phase_profiler.cpp
+//  async_pso
+//
+
+#include "phase_profiler.hpp"
+#include <vector>
+
+namespace pso {
+
+    // get a printable name for a phase
+    const char* to_string(phase_t phase) {
+        switch(phase){
+            case Iteration:     return "iteration";
+            case Evaluate:      return "evaluate";
+            case Update:        return "update";
+            case BestUpdate:    return "best update";
+            case Exchange:      return "exchange";
+            case MessageCheck:  return "message check";
+            case Serialize:     return "serialize";
+            case Migration:     return "migration";
+            case Stealing:      return "stealing";
+            case CacheShare:    return "cache share";
+            case Checkpoint:    return "checkpoint";
+            case Termination:   return "termination";
+            default:            return "unknown";
+        }
+    }
+
+    // ctor/dtor
+    phase_profiler::phase_profiler():tracer(nullptr) {
+        reset();
+    }
+
+    // clear all the accumulators
+    void phase_profiler::reset() {
+        for(int p = 0; p < NumPhases; ++p){
+            ticks[p]  = 0;
+            ncalls[p] = 0;
+        }
+    }
+
+    // set the recorder the phases are traced in
+    void phase_profiler::set_tracer(distributed::trace_recorder* rec) {
+        tracer = rec;
+    }
+
+    // get the time and calls of a phase on this rank
+    double phase_profiler::seconds(phase_t phase) const {
+        return 1e-9 * ticks[phase].load(std::memory_order_relaxed);
+    }
+    uint64_t phase_profiler::calls(phase_t phase) const {
+        return ncalls[phase].load(std::memory_order_relaxed);
+    }
+
+    // print the spread of the phase times over the ranks
+    void phase_profiler::report(MPI_Comm comm, FILE* out, const char* title) const {
+        if( !enabled() ){ return; }
+        int rank = 0, size = 1;
+        MPI_Comm_rank(comm, &rank);
+        MPI_Comm_size(comm, &size);
+
+        // the times and calls of all phases go out in one buffer, with
+        // the min, max and sum over the ranks reduced onto rank 0
+        std::vector<double> local(2*NumPhases), lo(2*NumPhases), hi(2*NumPhases), sum(2*NumPhases);
+        for(int p = 0; p < NumPhases; ++p){
+            local[p]             = seconds(static_cast<phase_t>(p));
+            local[NumPhases + p] = static_cast<double>(calls(static_cast<phase_t>(p)));
+        }
+        MPI_Reduce(local.data(), lo.data(), 2*NumPhases, MPI_DOUBLE, MPI_MIN, 0, comm);
+        MPI_Reduce(local.data(), hi.data(), 2*NumPhases, MPI_DOUBLE, MPI_MAX, 0, comm);
+        MPI_Reduce(local.data(), sum.data(), 2*NumPhases, MPI_DOUBLE, MPI_SUM, 0, comm);
+        if( rank != 0 ){ return; }
+
+        // phases that never ran on any rank are left out
+        const double iter_mean = sum[Iteration] / size;
+        fprintf(out, "Profile of %s over %i rank(s), seconds per rank\n", title, size);
+        fprintf(out, "%-14s %12s %11s %11s %11s %8s\n", "phase", "calls/rank", "min", "mean", "max", "%iter");
+        for(int p = 0; p < NumPhases; ++p){
+            if( sum[NumPhases + p] == 0.0 ){ continue; }
+            const double mean = sum[p] / size;
+            fprintf(out, "%-14s %12.1f %11.4e %11.4e %11.4e %8.2f\n", to_string(static_cast<phase_t>(p)),
+                    sum[NumPhases + p] / size, lo[p], mean, hi[p], iter_mean > 0.0 ? 100.0*mean/iter_mean : 0.0);
+        }
+        fflush(out);
+    }
+
+}// end namespace pso
@@ -0,0 +1,132 @@
+//
+//  phase_profiler.hpp
+//  async_pso
+//
+
+#ifndef phase_profiler_hpp
+#define phase_profiler_hpp
+
+#include <mpi.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include "../distr_utility/trace_recorder.hpp"
+
+namespace pso {
+
+    // phases of an iteration that get timed. Phases nest, so
+    // Iteration covers everything, Exchange covers the message
+    // checks it does and MessageCheck covers the serialization
+    // of the estimates it handles
+    enum phase_t: int {
+        Iteration = 0,  // a whole call to iterate
+        Evaluate,       // objective evaluations, including cache lookups
+        Update,         // particle velocity and position updates
+        BestUpdate,     // folding particle values into the best estimate
+        Exchange,       // sharing the best estimate with other ranks
+        MessageCheck,   // check_message_completeness on the estimate messages
+        Serialize,      // writing and reading estimate messages
+        Migration,      // particle migration between ranks
+        Stealing,       // handing out and taking evaluation work
+        CacheShare,     // sharing objective values between ranks
+        Checkpoint,     // taking checkpoint snapshots
+        Termination,    // checking and agreeing on a stop
+        NumPhases
+    };
+
+    // get a printable name for a phase
+    const char* to_string(phase_t phase);
+
+    /*
+     Per-rank accumulators of the time spent in each phase of
+     the swarms, filled in by scoped_phase timers. The times
+     are only added up in builds with APSO_PROFILE defined (make
+     PROFILE=1), and otherwise the timers do nothing unless there
+     is a trace recorder taking the phases as timeline events.
+     Phases timed on worker threads add up the time of all the threads.
+     */
+    class phase_profiler {
+    public:
+
+        // ctor/dtor
+        phase_profiler();
+        ~phase_profiler() = default;
+
+        // check whether the timers were compiled in
+        static constexpr bool enabled() {
+#ifdef APSO_PROFILE
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        // add a timed call of a phase
+        void add(phase_t phase, uint64_t nanoseconds) {
+            ticks[phase].fetch_add(nanoseconds, std::memory_order_relaxed);
+            ncalls[phase].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // clear all the accumulators
+        void reset();
+        
+        // set the recorder the phases are traced in, if any
+        void set_tracer(distributed::trace_recorder* rec);
+        distributed::trace_recorder* get_tracer() const {
+            return tracer;
+        }
+
+        // get the time and calls of a phase on this rank
+        double seconds(phase_t phase) const;
+        uint64_t calls(phase_t phase) const;
+
+        // print the min/mean/max time per rank and the mean calls per rank
+        // of each phase to out on rank 0 of the communicator, along with the
+        // share of the mean iteration time, which Termination is not part of
+        // as it is checked between iterations. Collective, and does nothing
+        // in builds without the timers
+        void report(MPI_Comm comm, FILE* out, const char* title) const;
+
+    private:
+
+        std::atomic<uint64_t> ticks[NumPhases];
+        std::atomic<uint64_t> ncalls[NumPhases];
+
+        distributed::trace_recorder* tracer;
+
+    };
+
+    /*
+     Timer adding the time from its construction to its destruction
+     to a phase of a profiler, if there is one, and recording it as
+     an event if the profiler has a trace recorder that is on
+     */
+    class scoped_phase {
+    public:
+
+        scoped_phase(phase_profiler* prof_, phase_t phase_):prof(prof_), phase(phase_), start(0) {
+            if( prof && !phase_profiler::enabled()
+               && !(prof->get_tracer() && prof->get_tracer()->is_enabled()) ){ prof = nullptr; }
+            if( prof ){ start = distributed::trace_recorder::now(); }
+        }
+        ~scoped_phase() {
+            if( !prof ){ return; }
+            const uint64_t end = distributed::trace_recorder::now();
+            if( phase_profiler::enabled() ){ prof->add(phase, end - start); }
+            if( prof->get_tracer() ){ prof->get_tracer()->complete(to_string(phase), "phase", start, end); }
+        }
+
+        scoped_phase(const scoped_phase&) = delete;
+        scoped_phase& operator=(const scoped_phase&) = delete;
+
+    private:
+
+        phase_profiler* prof;
+        phase_t         phase;
+        uint64_t        start;
+
+    };
+
+}// end namespace pso
+
+#endif /* phase_profiler_hpp */
@@ -0,0 +1,89 @@
+//
+//  termination.cpp
+//  async_pso
+//
+
+#include "termination.hpp"
+#include <cmath>
+#include <limits>
+
+namespace pso {
+
+    // get a printable name for a stop reason
+    const char* to_string(stop_reason_t reason) {
+        switch(reason){
+            case TargetReached:     return "target reached";
+            case Stalled:           return "stalled";
+            case WallTime:          return "wall time";
+            case MaxEvaluations:    return "max evaluations";
+            case SwarmCollapsed:    return "swarm collapsed";
+            case MaxIterations:     return "max iterations";
+            default:                return "not stopped";
+        }
+    }
+
+    // ctor, with everything but the target turned off
+    termination_criteria::termination_criteria():target_fval(std::numeric_limits<double>::lowest()),
+    stall_iterations(0), stall_tolerance(0.0), max_wall_time(0.0), max_evaluations(0),
+    diameter_tolerance(0.0), max_iterations(0)
+    {}
+
+    // ctor/dtor
+    termination_monitor::termination_monitor():stall_fval(std::numeric_limits<double>::max()), stall_start(0)
+    {
+        start(termination_criteria());
+    }
+
+    // start tracking a run with the given criteria
+    void termination_monitor::start(const termination_criteria& criteria) {
+        crit        = criteria;
+        start_time  = clock_t::now();
+        stall_fval  = std::numeric_limits<double>::max();
+        stall_start = 0;
+    }
+    const termination_criteria& termination_monitor::get_criteria() const {
+        return crit;
+    }
+
+    // check the criteria after some number of iterations
+    stop_reason_t termination_monitor::check(size_t iterations, double best_fval, size_t num_evals) {
+        if( best_fval <= crit.target_fval ){ return TargetReached; }
+
+        // restart the stall count whenever the best value improved enough
+        if( best_fval < stall_fval ){
+            const bool first = stall_fval == std::numeric_limits<double>::max();
+            if( first || stall_fval - best_fval > crit.stall_tolerance*std::abs(stall_fval) ){
+                stall_start = iterations;
+            }
+            stall_fval = best_fval;
+        }
+        if( crit.stall_iterations && iterations - stall_start >= crit.stall_iterations ){ return Stalled; }
+
+        if( crit.max_wall_time > 0.0 && elapsed() >= crit.max_wall_time ){ return WallTime; }
+        if( crit.max_evaluations && num_evals >= crit.max_evaluations ){ return MaxEvaluations; }
+        if( crit.max_iterations && iterations >= crit.max_iterations ){ return MaxIterations; }
+        return NotStopped;
+    }
+
+    // check the diameter criterion for a bounding box
+    bool termination_monitor::wants_diameter() const {
+        return crit.diameter_tolerance > 0.0;
+    }
+    stop_reason_t termination_monitor::check_diameter(const std::vector<double>& lo, const std::vector<double>& hi) const {
+        if( !wants_diameter() ){ return NotStopped; }
+
+        // an empty box has nothing to measure
+        double diag2 = 0.0;
+        for(size_t i = 0; i < lo.size() && i < hi.size(); ++i){
+            if( hi[i] < lo[i] ){ return NotStopped; }
+            diag2 += (hi[i] - lo[i])*(hi[i] - lo[i]);
+        }
+        return std::sqrt(diag2) < crit.diameter_tolerance ? SwarmCollapsed : NotStopped;
+    }
+
+    // get the time since the start of the run
+    double termination_monitor::elapsed() const {
+        return std::chrono::duration<double>(clock_t::now() - start_time).count();
+    }
+
+}// end namespace pso
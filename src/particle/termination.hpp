@@ -0,0 +1,94 @@
+//
+//  termination.hpp
+//  async_pso
+//
+
+#ifndef termination_hpp
+#define termination_hpp
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace pso {
+
+    // reasons a run can stop for
+    enum stop_reason_t: int {
+        NotStopped = 0,
+        TargetReached,      // best value at or below the target
+        Stalled,            // no improvement for a number of iterations
+        WallTime,           // ran out of time
+        MaxEvaluations,     // ran out of objective evaluations
+        SwarmCollapsed,     // the swarm shrank below the diameter tolerance
+        MaxIterations       // ran out of iterations
+    };
+
+    // get a printable name for a stop reason
+    const char* to_string(stop_reason_t reason);
+
+    /*
+     Criteria for stopping a run, where a criterion set to
+     zero is turned off. The evaluations are counted over all
+     ranks, and the swarm diameter is measured as the diagonal
+     of the bounding box of the particle positions, which is
+     an upper bound on the largest distance between particles.
+     */
+    struct termination_criteria {
+
+        // ctor, with everything but the target turned off
+        termination_criteria();
+
+        double  target_fval;        // stop once the best value is <= this
+        size_t  stall_iterations;   // iterations without improvement
+        double  stall_tolerance;    // relative improvement counting as progress
+        double  max_wall_time;      // seconds since the start of the run
+        size_t  max_evaluations;    // objective evaluations over all ranks
+        double  diameter_tolerance; // stop once the swarm is smaller than this
+        size_t  max_iterations;     // iterations of the run
+    };
+
+    /*
+     Class tracking the progress of a run against some
+     termination criteria. It only looks at the numbers
+     it is handed, so deciding on a stop together with
+     other ranks is left to the swarms.
+     */
+    class termination_monitor {
+    public:
+
+        // ctor/dtor
+        termination_monitor();
+        ~termination_monitor() = default;
+
+        // start tracking a run with the given criteria
+        void start(const termination_criteria& criteria);
+        const termination_criteria& get_criteria() const;
+
+        // check the criteria after some number of iterations of
+        // the run, given the best value and the evaluations so far
+        stop_reason_t check(size_t iterations, double best_fval, size_t num_evals);
+
+        // check the diameter criterion for a bounding box
+        // of the particle positions
+        bool wants_diameter() const;
+        stop_reason_t check_diameter(const std::vector<double>& lo, const std::vector<double>& hi) const;
+
+        // get the time since the start of the run
+        double elapsed() const;
+
+    private:
+
+        using clock_t = std::chrono::steady_clock;
+
+        termination_criteria    crit;
+        clock_t::time_point     start_time;
+
+        // best value at the last improvement and when it happened
+        double                  stall_fval;
+        size_t                  stall_start;
+
+    };
+
+}// end namespace pso
+
+#endif /* termination_hpp */
@@ -0,0 +1,189 @@
+//
+//  update_kernels.cpp
+//  async_pso
+//
+
+#include "update_kernels.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define APSO_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+// keep the compiler from fusing the separate multiplies and
+// adds into fma instructions inside the avx-512 kernel
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+namespace pso {
+    namespace kernels {
+
+        /*
+         Note: every kernel evaluates the velocity formula
+         with the same operation order and without fused
+         multiply-adds, so the results are bitwise identical
+         no matter which instruction set gets picked.
+         */
+
+        // update columns [i0, ld) of particle row k
+        static inline void scalar_row(const update_args& a, size_t k, size_t i0) {
+            double* p           = a.pos + k*a.ld;
+            double* v           = a.vel + k*a.ld;
+            const double* bp    = a.best_pos + k*a.ld;
+            const double* rl    = a.rl + k*a.ld;
+            const double* rg    = a.rg + k*a.ld;
+            for(size_t i = i0; i < a.ld; ++i){
+                double vn = a.w * v[i]
+                            + a.phi_l * rl[i] * (bp[i] - p[i])
+                            + a.phi_g * rg[i] * (a.gbest[i] - p[i]);
+                double pn = p[i] + vn;
+
+                // project back onto the boundary and
+                // zero the velocity if we left the domain
+                bool out  = (pn < a.lb[i]) | (pn > a.ub[i]);
+                pn        = pn < a.lb[i] ? a.lb[i] : pn;
+                pn        = pn > a.ub[i] ? a.ub[i] : pn;
+                v[i]      = out ? 0.0 : vn;
+                p[i]      = pn;
+            }
+        }
+
+        static void scalar_update(const update_args& a) {
+            for(size_t k = 0; k < a.num; ++k){
+                scalar_row(a, k, 0);
+            }
+        }
+
+#ifdef APSO_X86_DISPATCH
+
+        __attribute__((target("avx2")))
+        static void avx2_update(const update_args& a) {
+            const __m256d w     = _mm256_set1_pd(a.w);
+            const __m256d phi_l = _mm256_set1_pd(a.phi_l);
+            const __m256d phi_g = _mm256_set1_pd(a.phi_g);
+            const size_t nvec   = a.ld - (a.ld % 4);
+
+            for(size_t k = 0; k < a.num; ++k){
+                double* p           = a.pos + k*a.ld;
+                double* v           = a.vel + k*a.ld;
+                const double* bp    = a.best_pos + k*a.ld;
+                const double* rl    = a.rl + k*a.ld;
+                const double* rg    = a.rg + k*a.ld;
+                for(size_t i = 0; i < nvec; i += 4){
+                    __m256d pv = _mm256_loadu_pd(p + i);
+                    __m256d vv = _mm256_loadu_pd(v + i);
+                    __m256d lo = _mm256_loadu_pd(a.lb + i);
+                    __m256d hi = _mm256_loadu_pd(a.ub + i);
+
+                    // compute the new velocity
+                    __m256d tl = _mm256_mul_pd(_mm256_mul_pd(phi_l, _mm256_loadu_pd(rl + i)),
+                                               _mm256_sub_pd(_mm256_loadu_pd(bp + i), pv));
+                    __m256d tg = _mm256_mul_pd(_mm256_mul_pd(phi_g, _mm256_loadu_pd(rg + i)),
+                                               _mm256_sub_pd(_mm256_loadu_pd(a.gbest + i), pv));
+                    vv = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(w, vv), tl), tg);
+                    pv = _mm256_add_pd(pv, vv);
+
+                    // branch-free projection and velocity zeroing
+                    __m256d out = _mm256_or_pd(_mm256_cmp_pd(pv, lo, _CMP_LT_OQ),
+                                               _mm256_cmp_pd(pv, hi, _CMP_GT_OQ));
+                    pv = _mm256_min_pd(_mm256_max_pd(pv, lo), hi);
+                    vv = _mm256_andnot_pd(out, vv);
+
+                    _mm256_storeu_pd(p + i, pv);
+                    _mm256_storeu_pd(v + i, vv);
+                }
+                scalar_row(a, k, nvec);
+            }
+        }
+
+        __attribute__((target("avx512f")))
+        static void avx512_update(const update_args& a) {
+            const __m512d w     = _mm512_set1_pd(a.w);
+            const __m512d phi_l = _mm512_set1_pd(a.phi_l);
+            const __m512d phi_g = _mm512_set1_pd(a.phi_g);
+            const size_t nvec   = a.ld - (a.ld % 8);
+
+            for(size_t k = 0; k < a.num; ++k){
+                double* p           = a.pos + k*a.ld;
+                double* v           = a.vel + k*a.ld;
+                const double* bp    = a.best_pos + k*a.ld;
+                const double* rl    = a.rl + k*a.ld;
+                const double* rg    = a.rg + k*a.ld;
+                for(size_t i = 0; i < nvec; i += 8){
+                    __m512d pv = _mm512_loadu_pd(p + i);
+                    __m512d vv = _mm512_loadu_pd(v + i);
+                    __m512d lo = _mm512_loadu_pd(a.lb + i);
+                    __m512d hi = _mm512_loadu_pd(a.ub + i);
+
+                    // compute the new velocity
+                    __m512d tl = _mm512_mul_pd(_mm512_mul_pd(phi_l, _mm512_loadu_pd(rl + i)),
+                                               _mm512_sub_pd(_mm512_loadu_pd(bp + i), pv));
+                    __m512d tg = _mm512_mul_pd(_mm512_mul_pd(phi_g, _mm512_loadu_pd(rg + i)),
+                                               _mm512_sub_pd(_mm512_loadu_pd(a.gbest + i), pv));
+                    vv = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(w, vv), tl), tg);
+                    pv = _mm512_add_pd(pv, vv);
+
+                    // branch-free projection and velocity zeroing
+                    __mmask8 out = _mm512_cmp_pd_mask(pv, lo, _CMP_LT_OQ)
+                                 | _mm512_cmp_pd_mask(pv, hi, _CMP_GT_OQ);
+                    pv = _mm512_min_pd(_mm512_max_pd(pv, lo), hi);
+                    vv = _mm512_maskz_mov_pd(static_cast<__mmask8>(~out), vv);
+
+                    _mm512_storeu_pd(p + i, pv);
+                    _mm512_storeu_pd(v + i, vv);
+                }
+                scalar_row(a, k, nvec);
+            }
+        }
+
+#endif
+
+        // query what the current cpu supports
+        bool is_supported(isa_t isa) {
+            switch( isa ){
+                case Auto:
+                case Scalar:
+                    return true;
+#ifdef APSO_X86_DISPATCH
+                case AVX2:
+                    return __builtin_cpu_supports("avx2");
+                case AVX512:
+                    return __builtin_cpu_supports("avx512f");
+#endif
+                default:
+                    return false;
+            }
+        }
+        isa_t best_supported_isa() {
+            if( is_supported(AVX512) ){ return AVX512; }
+            if( is_supported(AVX2) ){ return AVX2; }
+            return Scalar;
+        }
+        const char* isa_name(isa_t isa) {
+            switch( isa ){
+                case Scalar:    return "scalar";
+                case AVX2:      return "avx2";
+                case AVX512:    return "avx512";
+                default:        return "auto";
+            }
+        }
+
+        // get the kernel for some instruction set
+        update_fn get_update_kernel(isa_t isa) {
+            if( isa == Auto || !is_supported(isa) ){
+                isa = best_supported_isa();
+            }
+            switch( isa ){
+#ifdef APSO_X86_DISPATCH
+                case AVX2:      return &avx2_update;
+                case AVX512:    return &avx512_update;
+#endif
+                default:        return &scalar_update;
+            }
+        }
+
+    }// end namespace kernels
+}// end namespace pso
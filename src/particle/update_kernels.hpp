@@ -0,0 +1,57 @@
+//
+//  update_kernels.hpp
+//  async_pso
+//
+
+#ifndef update_kernels_hpp
+#define update_kernels_hpp
+
+#include <cstddef>
+
+namespace pso {
+    namespace kernels {
+
+        // instruction sets an update kernel can be built for
+        enum isa_t: int {
+            Auto = 0,
+            Scalar,
+            AVX2,
+            AVX512
+        };
+
+        /*
+         Arguments for the velocity/position update of a set
+         of consecutive particle rows. All row arrays have a
+         leading dimension of ld, and gbest/lb/ub/rl/rg must
+         be padded out to ld entries (zeros in the padding).
+         */
+        struct update_args {
+            size_t          num;        // number of particle rows
+            size_t          ld;         // padded row length
+            double*         pos;        // num x ld positions
+            double*         vel;        // num x ld velocities
+            const double*   best_pos;   // num x ld personal bests
+            const double*   gbest;      // ld global best estimate
+            const double*   lb;         // ld lower bounds
+            const double*   ub;         // ld upper bounds
+            const double*   rl;         // num x ld local uniforms
+            const double*   rg;         // num x ld global uniforms
+            double          w, phi_l, phi_g;
+        };
+
+        // signature of an update kernel
+        using update_fn = void(*)(const update_args& args);
+
+        // query what the current cpu supports
+        bool is_supported(isa_t isa);
+        isa_t best_supported_isa();
+        const char* isa_name(isa_t isa);
+
+        // get the kernel for some instruction set. Requesting
+        // an unsupported set falls back to the best supported one
+        update_fn get_update_kernel(isa_t isa = Auto);
+
+    }// end namespace kernels
+}// end namespace pso
+
+#endif /* update_kernels_hpp */
@@ -9,9 +9,14 @@
 #ifndef sync_swarm_hpp
 #define sync_swarm_hpp
 
-#include <random>
+#include <cstdint>
+#include <string>
 #include <vector>
-#include "../particle/particle.hpp"
+#include "../particle/particle_block.hpp"
+#include "../particle/objective_eval.hpp"
+#include "../particle/termination.hpp"
+#include "../particle/checkpoint.hpp"
+#include "../particle/phase_profiler.hpp"
 
 namespace sync {
     namespace pso {
@@ -20,13 +25,23 @@ namespace sync {
         class swarm {
         public:
             
+            // ways of sharing the global best at a sync point
+            enum sync_mode_t: int {
+                Allgather = 0,  // gather every estimate, then scan them
+                Allreduce,      // reduce (fval, position) pairs to the best one
+                Overlapped      // nonblocking Allreduce, finished after the
+                                // next evaluations, so the shared estimate
+                                // reaches the particles one iteration later
+            };
+            
             //ctor/dtor
             swarm(int num_particles = 20);
-            ~swarm() = default;
+            ~swarm();
             
             // set the MPI communicator
             void set_print_flag(bool do_print);
             void set_mpi_comm(MPI_Comm com);
+            void set_seed(uint64_t seed);
             
             // set the bounds
             void set_bounds(const std::vector<double>& lb, const std::vector<double>& ub);
@@ -36,15 +51,67 @@ namespace sync {
             void set_momentum(double omega);
             void set_particle_weights(double phi_local, double phi_global);
             
+            // set how the global best is shared at a sync point
+            void set_sync_mode(sync_mode_t mode);
+            
+            // look up objective values in a cache of up to capacity
+            // positions (0 turns this off) before calling the objective,
+            // see pso::eval_cache. With share_period > 0 the values computed
+            // by all ranks are gathered into every cache each share_period
+            // iterations. Must be the same on all ranks
+            void set_eval_cache(size_t capacity, double quantum = 0.0, size_t share_period = 0);
+            const ::pso::eval_cache& get_eval_cache() const;
+            
+            // write a checkpoint of this rank's particles and the global
+            // best every period iterations (0 turns this off) in the
+            // background, see pso::checkpoint. It is committed at the next
+            // checkpoint or at finalize once every rank wrote it, waiting
+            // on the write if it is not done by then
+            void set_checkpointing(const std::string& prefix, size_t period);
+            const ::pso::checkpoint_writer& get_checkpoint_writer() const;
+            
+            // record the phases of the iterations as a timeline in a ring
+            // buffer of capacity events per rank (0 turns this off), written
+            // out at finalize as one Chrome trace file for all ranks, which
+            // chrome://tracing and Perfetto open. Must be the same on all
+            // ranks, see distributed::trace_recorder
+            void set_tracing(const std::string& file_name, size_t capacity = 1 << 16);
+            
             // initialize the swarm
             void initialize();
             
+            // replace the particles and global best set up by initialize
+            // with this rank's share of the last committed checkpoint, which
+            // may have been written by a different number of ranks. Returns
+            // false, keeping the initial state, if it can't be read
+            bool restart(const std::string& prefix);
+            
             // perform an iteration
             void iterate();
             
+            // iterate until the criteria are met, which are checked at every
+            // sync point, so all ranks stop at the same iteration. Outside of
+            // Allgather mode the check goes along with the reduction of the
+            // global best, so in Overlapped mode a stop is only seen at the
+            // sync point after it. Returns the reason for the stop
+            ::pso::stop_reason_t run(const ::pso::termination_criteria& criteria);
+            
+            // finish any pending reduction, free the MPI reduction type/op
+            // and commit the last checkpoint. Collective, and must be called
+            // before MPI_Finalize
+            void finalize();
+            
             // get the function reference
             func_type& get_objective_func();
             
+            // get the number of iterations done on this rank
+            size_t get_iteration_count() const;
+            
+            // get the time spent in each phase of the iterations on this
+            // rank since initialize, which is only measured in builds with
+            // APSO_PROFILE defined, see pso::phase_profiler::report
+            const ::pso::phase_profiler& get_profiler() const;
+            
             // methods to retrieve the optimal objective
             // function and position for the swarm on this rank
             double get_best_objective_value() const;
@@ -58,7 +125,10 @@ namespace sync {
             double w, phi_l, phi_g;
             
             // particles of the swarm
-            std::vector<::pso::particle>    particles;
+            size_t                          num_particles;
+            ::pso::particle_block           particles;
+            std::vector<double>             xeval;
+            std::vector<double>             fvals;
             std::vector<double>             gbest_pos;
             double                          gbest_fval;
             
@@ -66,6 +136,39 @@ namespace sync {
             std::vector<double> send_buf;
             std::vector<double> recv_buf;
             
+            // reduction of (fval, position) pairs
+            sync_mode_t     sync_mode;
+            MPI_Datatype    best_type;
+            MPI_Op          best_op;
+            MPI_Request     reduce_req;
+            
+            // stopping criteria and the buffer for agreeing on a stop, along
+            // with the number of termination fields in the best reductions,
+            // the iteration the run started at, the evaluations per iteration
+            // and the stop reason the last reduction agreed on
+            ::pso::termination_monitor  monitor;
+            std::vector<double>         term_buf, box_lo, box_hi;
+            size_t                      nterm, run_start;
+            unsigned long long          evals_per_iter;
+            ::pso::stop_reason_t        term_reason;
+            
+            // cache of objective values and the buffers for sharing it
+            ::pso::eval_cache       cache;
+            ::pso::cache_scratch    cache_scratch;
+            size_t                  share_period;
+            std::vector<double>     share_send, share_recv;
+            std::vector<int>        share_counts, share_displs;
+            
+            // checkpoints of the particles and the epoch of the last one
+            ::pso::checkpoint_writer    ckpt_writer;
+            size_t                      ckpt_period, ckpt_epoch;
+            
+            // time spent in each phase, and the timeline of the phases
+            ::pso::phase_profiler       profiler;
+            distributed::trace_recorder trace;
+            std::string                 trace_file;
+            size_t                      trace_capacity;
+            
             // bounds for the domain
             std::vector<double> lb, ub;
             
@@ -73,12 +176,27 @@ namespace sync {
             func_type objective_func;
             
             // random number generator
-            std::mt19937 gen;
+            uint64_t            seed;
+            ::pso::counter_rng  rng;
             
             // MPI stuff
             int local_rank, tot_ranks;
             MPI_Comm comm;
             
+            // helper methods for the sync points
+            void sync_allgather();
+            void setup_reduction(size_t nterm);
+            void start_reduction();
+            void finish_reduction();
+            void free_reduction();
+            void print_best() const;
+            void share_cache();
+            ::pso::stop_reason_t check_termination();
+            void pack_termination(double* buf, size_t nbox);
+            ::pso::stop_reason_t unpack_termination(const double* buf, size_t nbox);
+            
+            // reduction picking the pair with the lowest fval
+            static void min_best(void* in, void* inout, int* len, MPI_Datatype* type);
             
         };
         
@@ -12,6 +12,7 @@
 #define HEADER template<typename func_type>
 #define CLASS swarm<func_type>
 
+#include <algorithm>
 #include <limits>
 #include "sync_swarm.hpp"
 
@@ -20,24 +21,36 @@ namespace sync {
         
         
         //ctor/dtor
-        HEADER CLASS::swarm(int num_particles):particles(num_particles), frequency(1),
-        w(0.9),phi_l(0.7), phi_g(0.5), do_print(true)
+        HEADER CLASS::swarm(int num_particles_):num_particles(num_particles_), frequency(1),
+        w(0.9),phi_l(0.7), phi_g(0.5), do_print(true), sync_mode(Allgather),
+        best_type(MPI_DATATYPE_NULL), best_op(MPI_OP_NULL), reduce_req(MPI_REQUEST_NULL),
+        nterm(0), run_start(0), evals_per_iter(0), term_reason(::pso::NotStopped),
+        share_period(0), ckpt_period(0), ckpt_epoch(0), trace_capacity(0)
         {
             comm = MPI_COMM_WORLD;
             MPI_Comm_rank(comm, &local_rank);
             MPI_Comm_size(comm, &tot_ranks);
-            int seed_val = (local_rank*1749 << 4) ^ 17;
-            gen.seed(seed_val);
+            set_seed(17);
             gbest_fval = std::numeric_limits<double>::max();
         }
+        HEADER CLASS::~swarm() {
+            
+            // the type and op can only be freed while MPI is still up
+            int finalized = 0;
+            MPI_Finalized(&finalized);
+            if( !finalized ){ free_reduction(); }
+        }
         
         HEADER void CLASS::set_mpi_comm(MPI_Comm com) {
             MPI_Comm_rank(com, &local_rank);
             MPI_Comm_size(com, &tot_ranks);
-            gen.seed(local_rank);
             comm = com;
         }
         
+        HEADER void CLASS::set_seed(uint64_t seed_) {
+            seed = seed_;
+        }
+        
         HEADER void CLASS::set_print_flag(bool do_print_) {
             do_print = do_print_;
         }
@@ -62,86 +75,370 @@ namespace sync {
             frequency = freq;
         }
         
+        // set how the global best is shared at a sync point
+        HEADER void CLASS::set_sync_mode(sync_mode_t mode) {
+            sync_mode = mode;
+        }
+        
+        // look up objective values in a cache
+        HEADER void CLASS::set_eval_cache(size_t capacity, double quantum, size_t share_period_) {
+            cache.set_capacity(capacity);
+            cache.set_quantum(quantum);
+            share_period = capacity ? share_period_ : 0;
+            cache.set_sharing(share_period > 0);
+        }
+        HEADER const ::pso::eval_cache& CLASS::get_eval_cache() const {
+            return cache;
+        }
+        
+        // write checkpoints in the background
+        HEADER void CLASS::set_checkpointing(const std::string& prefix, size_t period) {
+            ckpt_writer.set_prefix(prefix);
+            ckpt_period = period;
+        }
+        HEADER const ::pso::checkpoint_writer& CLASS::get_checkpoint_writer() const {
+            return ckpt_writer;
+        }
+        
+        // record the phases as a timeline
+        HEADER void CLASS::set_tracing(const std::string& file_name, size_t capacity) {
+            trace_file     = file_name;
+            trace_capacity = file_name.empty() ? 0 : capacity;
+        }
+        
         // initialize the swarm
         HEADER void CLASS::initialize() {
-            counter = 0;
+            counter    = 0;
+            ckpt_epoch = 0;
             size_t dim = lb.size();
-            for(auto&p: particles){
-                p.set_num_dims(dim);
-                p.initialize( gen, lb, ub );
-                p.set_momentum(w);
-                p.set_particle_weights(phi_l, phi_g);
-            }
+            xeval.resize(dim);
+            fvals.resize(num_particles);
+            particles.resize(num_particles, dim);
+            particles.set_momentum(w);
+            particles.set_particle_weights(phi_l, phi_g);
+            
+            // each particle draws from its own stream, keyed by
+            // the rank and its local index
+            rng.set_seed(seed);
+            particles.set_stream_ids(static_cast<uint64_t>(local_rank) << 32);
+            particles.initialize( rng, lb, ub );
             recv_buf.resize( (dim+1) * tot_ranks );
+            setup_reduction(0);
+            profiler.reset();
+            trace.enable(trace_capacity);
+            profiler.set_tracer(trace_capacity ? &trace : nullptr);
+        }
+        
+        // replace the initial state with a checkpoint
+        HEADER bool CLASS::restart(const std::string& prefix) {
+            ::pso::checkpoint::state_t state;
+            if( !::pso::checkpoint::read(prefix, local_rank, tot_ranks, particles, state) ){ return false; }
+            num_particles = particles.size();
+            fvals.resize(num_particles);
+            counter    = state.iteration;
+            ckpt_epoch = state.epoch;
+            gbest_fval = state.best_fval;
+            gbest_pos  = state.best_pos;
+            
+            // the checkpoints we take from here on replace the ones we read
+            if( prefix == ckpt_writer.get_prefix() ){ ckpt_writer.set_committed(state); }
+            return true;
         }
         
         // perform an iteration
         HEADER void CLASS::iterate() {
+            ::pso::scoped_phase timer(&profiler, ::pso::Iteration);
             
-            // compute the values of the particles
-            for(auto& p: particles){
-                double fval = objective_func(p.get_current_position());
-                p.set_function_value(fval);
-                
-                // set values into the global estimate tracker
-                if( fval < gbest_fval ){
-                    auto& bsoln = p.get_best_position();
-                    for(size_t i = 0; i < bsoln.size(); ++i){
-                        gbest_pos[i] = bsoln[i];
+            // compute the values of the particles, in one call
+            // if the objective supports batch evaluation
+            const size_t dim = particles.num_dims();
+            const size_t nparts = particles.size();
+            {
+                ::pso::scoped_phase eval_timer(&profiler, ::pso::Evaluate);
+                ::pso::evaluate_particles(objective_func, cache, cache_scratch, particles, 0, nparts, fvals.data(), xeval);
+            }
+            
+            {
+                ::pso::scoped_phase best_timer(&profiler, ::pso::BestUpdate);
+                for(size_t k = 0; k < nparts; ++k){
+                    particles.set_function_value(k, fvals[k]);
+                    
+                    // set values into the global estimate tracker
+                    if( fvals[k] < gbest_fval ){
+                        const double* x = particles.position(k);
+                        for(size_t i = 0; i < dim; ++i){
+                            gbest_pos[i] = x[i];
+                        }
+                        gbest_fval = fvals[k];
                     }
-                    gbest_fval = fval;
                 }
             }
             
-            // send out message and receive results, if necessary
-            if( ++counter % frequency == 0 ){
-                
-                // get the number of data being used here
-                int num_data = static_cast<int>(lb.size()) + 1;
-                
-                // fill the send buffer
-                send_buf[0] = gbest_fval;
-                for(int i = 0; i < gbest_pos.size(); ++i){
-                    send_buf[i+1] = gbest_pos[i];
-                }
+            {
+                ::pso::scoped_phase exchange_timer(&profiler, ::pso::Exchange);
                 
-                // synchronize
-                MPI_Allgather(&send_buf[0], num_data, MPI_DOUBLE,
-                              &recv_buf[0], num_data, MPI_DOUBLE,
-                              comm);
+                // finish the reduction started at the previous sync point
+                if( reduce_req != MPI_REQUEST_NULL ){ finish_reduction(); }
                 
-                // update the optimal result
-                int opt_index = 0;
-                double bval = recv_buf[0];
-                for(int i = 1; i < tot_ranks; ++i){
-                    const double ival = recv_buf[i*num_data];
-                    if( ival < bval ){
-                        bval = ival;
-                        opt_index = i;
+                // send out message and receive results, if necessary
+                if( ++counter % frequency == 0 ){
+                    if( sync_mode == Allgather ){ sync_allgather(); }
+                    else{
+                        start_reduction();
+                        if( sync_mode == Allreduce ){ finish_reduction(); }
                     }
-                }// for i
-                
-                gbest_fval = bval;
-                for(size_t i = 0; i < lb.size(); ++i){
-                    gbest_pos[i] = recv_buf[(i+1) + opt_index*num_data];
                 }
-                
-                // print message
-                if( do_print ){
-                    printf("Rank(%i): f_{best} = %0.5e @ [ ", local_rank, gbest_fval);
-                    for(size_t i = 0; i < gbest_pos.size(); ++i){
-                        printf("%0.3e ", gbest_pos[i]);
-                    }
-                    printf("]\n");
+            }
+            
+            // gather the objective values computed by all ranks
+            if( share_period && counter % share_period == 0 ){
+                ::pso::scoped_phase share_timer(&profiler, ::pso::CacheShare);
+                share_cache();
+            }
+            
+            // update the particles with the current
+            // global best estimate
+            {
+                ::pso::scoped_phase update_timer(&profiler, ::pso::Update);
+                particles.update(gbest_pos);
+            }
+            
+            // commit the last checkpoint and snapshot the particles
+            // for the next, which is written in the background
+            if( ckpt_period && counter % ckpt_period == 0 ){
+                ::pso::scoped_phase ckpt_timer(&profiler, ::pso::Checkpoint);
+                ckpt_writer.commit(comm);
+                ckpt_writer.write(local_rank, tot_ranks, particles, ++ckpt_epoch, counter, gbest_fval, gbest_pos);
+            }
+        }
+        
+        // iterate until the criteria are met
+        HEADER ::pso::stop_reason_t CLASS::run(const ::pso::termination_criteria& criteria) {
+            
+            // every iteration evaluates all the particles of all the ranks
+            unsigned long long local_evals = particles.size(), num_evals = 0;
+            MPI_Allreduce(&local_evals, &num_evals, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, comm);
+            evals_per_iter = num_evals;
+            
+            monitor.start(criteria);
+            run_start   = counter;
+            term_reason = ::pso::NotStopped;
+            
+            // outside of Allgather mode the stop reasons and bounding boxes
+            // go along with the reductions of the global best, so checking
+            // the criteria costs no extra collective and does not wait on
+            // the overlapped reduction
+            const bool reduce = sync_mode != Allgather;
+            const size_t nbox = monitor.wants_diameter() ? particles.num_dims() : 0;
+            if( reduce ){ setup_reduction(1 + 2*nbox); }
+            
+            ::pso::stop_reason_t reason = ::pso::NotStopped;
+            while( reason == ::pso::NotStopped ){
+                iterate();
+                if( reduce ){ reason = term_reason; }
+                else if( counter % frequency == 0 ){
+                    ::pso::scoped_phase timer(&profiler, ::pso::Termination);
+                    reason = check_termination();
+                }
+            }
+            if( reduce ){ setup_reduction(0); }
+            return reason;
+        }
+        
+        // check the criteria on all ranks, with the stop reasons and the
+        // bounding boxes of the positions reduced in a single call
+        HEADER ::pso::stop_reason_t CLASS::check_termination() {
+            const size_t nbox = monitor.wants_diameter() ? particles.num_dims() : 0;
+            term_buf.resize(1 + 2*nbox);
+            pack_termination(term_buf.data(), nbox);
+            MPI_Allreduce(MPI_IN_PLACE, term_buf.data(), static_cast<int>(term_buf.size()), MPI_DOUBLE, MPI_MAX, comm);
+            return unpack_termination(term_buf.data(), nbox);
+        }
+        
+        // write the stop reason of this rank and the bounding box of its
+        // positions, negating the lower bounds so all reduce with a max
+        HEADER void CLASS::pack_termination(double* buf, size_t nbox) {
+            const size_t iterations = counter - run_start;
+            buf[0] = static_cast<double>(monitor.check(iterations, gbest_fval, iterations * evals_per_iter));
+            if( nbox ){
+                particles.position_bounds(box_lo, box_hi);
+                for(size_t i = 0; i < nbox; ++i){
+                    buf[1+i]      = box_hi[i];
+                    buf[1+nbox+i] = -box_lo[i];
+                }
+            }
+        }
+        
+        // get the stop reason out of the reduced reasons and boxes,
+        // which every rank ends up with the same copy of
+        HEADER ::pso::stop_reason_t CLASS::unpack_termination(const double* buf, size_t nbox) {
+            ::pso::stop_reason_t reason = static_cast<::pso::stop_reason_t>(static_cast<int>(buf[0]));
+            if( reason == ::pso::NotStopped && nbox ){
+                for(size_t i = 0; i < nbox; ++i){
+                    box_hi[i] = buf[1+i];
+                    box_lo[i] = -buf[1+nbox+i];
                 }
+                reason = monitor.check_diameter(box_lo, box_hi);
             }
+            return reason;
+        }
+        
+        // finish any pending reduction and free the reduction type/op
+        HEADER void CLASS::finalize() {
+            if( reduce_req != MPI_REQUEST_NULL ){ finish_reduction(); }
+            free_reduction();
+            if( ckpt_period ){ ckpt_writer.commit(comm); }
+            if( trace.is_enabled() ){ trace.write(comm, trace_file); }
+        }
+        
+        // share the global best by gathering all the estimates
+        HEADER void CLASS::sync_allgather() {
             
-            // update the particles
-            for(auto& p: particles){
-                
-                // update the particle with the current
-                // global best estimate
-                p.update(gbest_pos);
+            // get the number of data being used here
+            int num_data = static_cast<int>(lb.size()) + 1;
+            
+            // fill the send buffer
+            send_buf[0] = gbest_fval;
+            for(int i = 0; i < gbest_pos.size(); ++i){
+                send_buf[i+1] = gbest_pos[i];
+            }
+            
+            // synchronize
+            MPI_Allgather(&send_buf[0], num_data, MPI_DOUBLE,
+                          &recv_buf[0], num_data, MPI_DOUBLE,
+                          comm);
+            
+            // update the optimal result
+            int opt_index = 0;
+            double bval = recv_buf[0];
+            for(int i = 1; i < tot_ranks; ++i){
+                const double ival = recv_buf[i*num_data];
+                if( ival < bval ){
+                    bval = ival;
+                    opt_index = i;
+                }
+            }// for i
+            
+            gbest_fval = bval;
+            for(size_t i = 0; i < lb.size(); ++i){
+                gbest_pos[i] = recv_buf[(i+1) + opt_index*num_data];
+            }
+            
+            print_best();
+        }
+        
+        // set up the type and op for reducing records made of the number
+        // of termination fields, the fields and the (fval, position) pair
+        HEADER void CLASS::setup_reduction(size_t nterm_) {
+            if( reduce_req != MPI_REQUEST_NULL ){ finish_reduction(); }
+            free_reduction();
+            nterm = nterm_;
+            if( sync_mode == Allgather ){ return; }
+            
+            const size_t num_data = 1 + nterm + lb.size() + 1;
+            send_buf.resize(std::max(send_buf.size(), num_data));
+            recv_buf.resize(std::max(recv_buf.size(), num_data));
+            MPI_Type_contiguous(static_cast<int>(num_data), MPI_DOUBLE, &best_type);
+            MPI_Type_commit(&best_type);
+            MPI_Op_create(&CLASS::min_best, 1, &best_op);
+        }
+        
+        // start reducing the (fval, position) pairs of all ranks
+        HEADER void CLASS::start_reduction() {
+            
+            // the send buffer stays untouched until the reduction is done
+            const size_t off = 1 + nterm;
+            send_buf[0] = static_cast<double>(nterm);
+            if( nterm ){
+                ::pso::scoped_phase timer(&profiler, ::pso::Termination);
+                pack_termination(&send_buf[1], (nterm - 1) / 2);
+            }
+            send_buf[off] = gbest_fval;
+            for(size_t i = 0; i < gbest_pos.size(); ++i){
+                send_buf[off+i+1] = gbest_pos[i];
+            }
+            MPI_Iallreduce(&send_buf[0], &recv_buf[0], 1, best_type, best_op, comm, &reduce_req);
+        }
+        
+        // wait on the reduction and take the result, unless the
+        // local estimate improved past it in the meantime
+        HEADER void CLASS::finish_reduction() {
+            MPI_Wait(&reduce_req, MPI_STATUS_IGNORE);
+            const size_t off = 1 + nterm;
+            if( recv_buf[off] <= gbest_fval ){
+                gbest_fval = recv_buf[off];
+                for(size_t i = 0; i < gbest_pos.size(); ++i){
+                    gbest_pos[i] = recv_buf[off+i+1];
+                }
+            }
+            if( nterm ){ term_reason = unpack_termination(&recv_buf[1], (nterm - 1) / 2); }
+            
+            print_best();
+        }
+        
+        // free the reduction type/op
+        HEADER void CLASS::free_reduction() {
+            if( best_type != MPI_DATATYPE_NULL ){ MPI_Type_free(&best_type); }
+            if( best_op != MPI_OP_NULL ){ MPI_Op_free(&best_op); }
+        }
+        
+        // gather the values each rank computed since the last
+        // share into the caches of all the ranks
+        HEADER void CLASS::share_cache() {
+            const size_t dim = particles.num_dims();
+            const size_t row = dim + 1;
+            const int count = static_cast<int>(cache.take_recent(share_send, dim, particles.size()) * row);
+            
+            share_counts.resize(tot_ranks);
+            share_displs.resize(tot_ranks);
+            MPI_Allgather(&count, 1, MPI_INT, share_counts.data(), 1, MPI_INT, comm);
+            int total = 0;
+            for(int r = 0; r < tot_ranks; ++r){
+                share_displs[r] = total;
+                total += share_counts[r];
+            }
+            share_recv.resize(total);
+            MPI_Allgatherv(share_send.data(), count, MPI_DOUBLE,
+                           share_recv.data(), share_counts.data(), share_displs.data(), MPI_DOUBLE, comm);
+            
+            // store what the other ranks computed
+            for(int r = 0; r < tot_ranks; ++r){
+                if( r == local_rank ){ continue; }
+                for(int k = share_displs[r]; k < share_displs[r] + share_counts[r]; k += static_cast<int>(row)){
+                    cache.insert_shared(&share_recv[k], dim, share_recv[k+dim]);
+                }
+            }
+        }
+        
+        // print the global best estimate
+        HEADER void CLASS::print_best() const {
+            if( do_print ){
+                printf("Rank(%i): f_{best} = %0.5e @ [ ", local_rank, gbest_fval);
+                for(size_t i = 0; i < gbest_pos.size(); ++i){
+                    printf("%0.3e ", gbest_pos[i]);
+                }
+                printf("]\n");
+            }
+        }
+        
+        // reduction taking the max of the termination fields and picking
+        // the pair with the lowest fval, where ties go to the lexicographically
+        // smaller position so the op is commutative
+        HEADER void CLASS::min_best(void* in, void* inout, int* len, MPI_Datatype* type) {
+            int nbytes = 0;
+            MPI_Type_size(*type, &nbytes);
+            const size_t num_data = static_cast<size_t>(nbytes) / sizeof(double);
+            
+            const double* a = static_cast<const double*>(in);
+            double* b = static_cast<double*>(inout);
+            for(int k = 0; k < *len; ++k, a += num_data, b += num_data){
+                const size_t off = 1 + static_cast<size_t>(b[0]);
+                for(size_t j = 1; j < off; ++j){
+                    b[j] = std::max(a[j], b[j]);
+                }
+                bool take = a[off] < b[off]
+                || ( a[off] == b[off] && std::lexicographical_compare(a+off+1, a+num_data, b+off+1, b+num_data) );
+                if( take ){ std::copy(a+off, a+num_data, b+off); }
             }
         }
         
@@ -150,6 +447,16 @@ namespace sync {
             return objective_func;
         }
         
+        // get the number of iterations done on this rank
+        HEADER size_t CLASS::get_iteration_count() const {
+            return counter;
+        }
+        
+        // get the time spent in each phase
+        HEADER const ::pso::phase_profiler& CLASS::get_profiler() const {
+            return profiler;
+        }
+        
         HEADER double CLASS::get_best_objective_value() const {
             return gbest_fval;
         }
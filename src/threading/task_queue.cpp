@@ -0,0 +1,59 @@
+//
+//  task_queue.cpp
+//  async_pso
+//
+
+#include "task_queue.hpp"
+
+namespace threading {
+
+    // ctor/dtor
+    task_queue::task_queue():budget(0), issued(0) {
+
+    }
+
+    // drop all the tasks in the queue
+    void task_queue::clear() {
+        std::lock_guard<std::mutex> lk(lock);
+        tasks.clear();
+    }
+
+    // set how many pops may succeed from now on
+    void task_queue::set_budget(size_t budget_) {
+        std::lock_guard<std::mutex> lk(lock);
+        budget = budget_;
+        issued = 0;
+    }
+
+    // add a task to the back of the queue
+    void task_queue::push(size_t task) {
+        {
+            std::lock_guard<std::mutex> lk(lock);
+            tasks.push_back(task);
+        }
+        cv.notify_one();
+    }
+
+    // pop a task from the front of the queue
+    bool task_queue::pop(size_t& task) {
+        std::unique_lock<std::mutex> lk(lock);
+        cv.wait(lk, [this]{ return issued >= budget || !tasks.empty(); });
+        if( issued >= budget ){
+            cv.notify_all();
+            return false;
+        }
+        task = tasks.front();
+        tasks.pop_front();
+        
+        // wake up any waiting threads once the budget runs out
+        if( ++issued == budget ){ cv.notify_all(); }
+        return true;
+    }
+
+    // get the number of tasks handed out since the budget was set
+    size_t task_queue::num_issued() const {
+        std::lock_guard<std::mutex> lk(lock);
+        return issued;
+    }
+
+}// end namespace threading
@@ -0,0 +1,55 @@
+//
+//  task_queue.hpp
+//  async_pso
+//
+
+#ifndef task_queue_hpp
+#define task_queue_hpp
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace threading {
+
+    /*
+     FIFO queue of task ids shared by a set of threads, where
+     only a fixed budget of tasks is handed out before the queue
+     reports it is exhausted. Tasks are expected to be pushed back
+     once processed, so a pop blocks while every task is in flight.
+     */
+    class task_queue {
+    public:
+
+        // ctor/dtor
+        task_queue();
+        ~task_queue() = default;
+
+        // drop all the tasks in the queue
+        void clear();
+
+        // set how many pops may succeed from now on
+        void set_budget(size_t budget);
+
+        // add a task to the back of the queue
+        void push(size_t task);
+
+        // pop a task from the front of the queue, waiting for one to be
+        // pushed if needed. Returns false once the budget is used up.
+        bool pop(size_t& task);
+
+        // get the number of tasks handed out since the budget was set
+        size_t num_issued() const;
+
+    private:
+        size_t                  budget, issued;
+        std::deque<size_t>      tasks;
+        mutable std::mutex      lock;
+        std::condition_variable cv;
+
+    };
+
+}// end namespace threading
+
+#endif /* task_queue_hpp */
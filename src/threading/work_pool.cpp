@@ -0,0 +1,142 @@
+//
+//  work_pool.cpp
+//  async_pso
+//
+
+#include "work_pool.hpp"
+
+namespace threading {
+
+    // ctor/dtor
+    work_pool::work_pool(int num_threads):nthreads(0), active(0), stop(false), generation(0), job(nullptr) {
+        resize(num_threads);
+    }
+    work_pool::~work_pool() {
+        shutdown();
+    }
+
+    // set/get the number of threads, including the caller
+    void work_pool::resize(int num_threads) {
+        if( num_threads < 1 ){ num_threads = 1; }
+        if( num_threads == nthreads ){ return; }
+        shutdown();
+
+        // create the chunk queues and the worker threads
+        nthreads = num_threads;
+        stop     = false;
+        queues.resize(0);
+        for(int t = 0; t < nthreads; ++t){
+            queues.emplace_back(new chunk_queue());
+            queues.back()->steals = 0;
+        }
+        for(int t = 1; t < nthreads; ++t){
+            threads.emplace_back(&work_pool::worker_loop, this, t);
+        }
+    }
+    int work_pool::num_threads() const {
+        return nthreads;
+    }
+
+    // run fn over chunks [0, num_chunks) and block until done
+    void work_pool::parallel_for(size_t num_chunks, const task_fn& fn) {
+
+        // with a single thread just run everything inline
+        if( nthreads == 1 ){
+            for(size_t c = 0; c < num_chunks; ++c){ fn(c, 0); }
+            return;
+        }
+
+        // hand each thread a contiguous range of chunks
+        // and wake up the workers
+        {
+            std::lock_guard<std::mutex> lk(m);
+            job = &fn;
+            for(int t = 0; t < nthreads; ++t){
+                size_t first = (num_chunks * t) / nthreads;
+                size_t last  = (num_chunks * (t+1)) / nthreads;
+                auto& q = queues[t]->chunks;
+                q.clear();
+                for(size_t c = first; c < last; ++c){ q.push_back(c); }
+            }
+            active = nthreads - 1;
+            ++generation;
+        }
+        cv_start.notify_all();
+
+        // do our share of the work, then wait for
+        // every worker to get done with theirs
+        run_chunks(0);
+        std::unique_lock<std::mutex> lk(m);
+        cv_done.wait(lk, [this]{ return active == 0; });
+        job = nullptr;
+    }
+
+    // get the number of chunks stolen by some thread so far
+    size_t work_pool::num_steals(int thread_id) const {
+        return queues[thread_id]->steals;
+    }
+
+    void work_pool::worker_loop(int thread_id) {
+        size_t seen = 0;
+        while( true ){
+
+            // wait for a new batch of work
+            {
+                std::unique_lock<std::mutex> lk(m);
+                cv_start.wait(lk, [&]{ return stop || generation != seen; });
+                if( stop ){ return; }
+                seen = generation;
+            }
+
+            // process chunks until there are none left
+            run_chunks(thread_id);
+
+            // mark this worker as done
+            {
+                std::lock_guard<std::mutex> lk(m);
+                if( --active == 0 ){ cv_done.notify_all(); }
+            }
+        }
+    }
+
+    void work_pool::run_chunks(int thread_id) {
+        size_t chunk = 0;
+        while( pop_own(thread_id, chunk) || steal(thread_id, chunk) ){
+            (*job)(chunk, thread_id);
+        }
+    }
+
+    bool work_pool::pop_own(int thread_id, size_t& chunk) {
+        chunk_queue& q = *queues[thread_id];
+        std::lock_guard<std::mutex> lk(q.lock);
+        if( q.chunks.empty() ){ return false; }
+        chunk = q.chunks.front();
+        q.chunks.pop_front();
+        return true;
+    }
+
+    bool work_pool::steal(int thread_id, size_t& chunk) {
+        for(int i = 1; i < nthreads; ++i){
+            chunk_queue& q = *queues[(thread_id + i) % nthreads];
+            std::lock_guard<std::mutex> lk(q.lock);
+            if( !q.chunks.empty() ){
+                chunk = q.chunks.back();
+                q.chunks.pop_back();
+                ++queues[thread_id]->steals;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work_pool::shutdown() {
+        {
+            std::lock_guard<std::mutex> lk(m);
+            stop = true;
+        }
+        cv_start.notify_all();
+        for(auto& t: threads){ t.join(); }
+        threads.resize(0);
+    }
+
+}// end namespace threading
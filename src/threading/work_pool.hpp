@@ -0,0 +1,78 @@
+//
+//  work_pool.hpp
+//  async_pso
+//
+
+#ifndef work_pool_hpp
+#define work_pool_hpp
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace threading {
+
+    /*
+     Fixed size pool of worker threads used to split the
+     particles of a rank into chunks. The thread calling
+     parallel_for takes part in the work as thread 0, so a
+     pool of size 1 runs everything inline. Each thread starts
+     with a contiguous range of chunks in its own queue and
+     steals from the back of other queues once it runs dry.
+     */
+    class work_pool {
+    public:
+
+        // type of the work function, called as fn(chunk, thread_id)
+        using task_fn = std::function<void(size_t, int)>;
+
+        // ctor/dtor
+        work_pool(int num_threads = 1);
+        ~work_pool();
+
+        // set/get the number of threads, including the caller
+        void resize(int num_threads);
+        int num_threads() const;
+
+        // run fn over chunks [0, num_chunks) and block until done.
+        // Must only be called from the thread that owns the pool.
+        void parallel_for(size_t num_chunks, const task_fn& fn);
+
+        // get the number of chunks stolen by some thread so far
+        size_t num_steals(int thread_id) const;
+
+    private:
+
+        // queue of chunks owned by a thread
+        struct chunk_queue {
+            std::mutex          lock;
+            std::deque<size_t>  chunks;
+            size_t              steals;
+        };
+
+        // internal state
+        int                                         nthreads, active;
+        bool                                        stop;
+        size_t                                      generation;
+        const task_fn*                              job;
+        std::vector<std::thread>                    threads;
+        std::vector<std::unique_ptr<chunk_queue>>   queues;
+        std::mutex                                  m;
+        std::condition_variable                     cv_start, cv_done;
+
+        // methods for the workers
+        void worker_loop(int thread_id);
+        void run_chunks(int thread_id);
+        bool pop_own(int thread_id, size_t& chunk);
+        bool steal(int thread_id, size_t& chunk);
+        void shutdown();
+
+    };
+
+}// end namespace threading
+
+#endif /* work_pool_hpp */